@@ -8,19 +8,76 @@
 #include <stdio.h>
 #include <math.h>
 #include <iterator>
+#include <algorithm>
 #include <stdlib.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <sys/resource.h>
 
 #include "skip_list.h"
+#include "lock_free_skip_list.h"
+#include "mvcc_skip_list.h"
+#include "unrolled_skip_list.h"
+#include "no_hot_spot_skip_list.h"
+#include "sharded_skip_list.h"
+#include "key_search.h"
+#include "node_allocator.h"
+#include "numa_support.h"
+#include "level_generator.h"
 
 using namespace std;
 
 size_t num_threads = 1;
 SkipList skiplist;
+LockFreeSkipList lock_free_skiplist;
+MvccSkipList<int, string> *mvcc_skiplist = NULL;
+NoHotSpotSkipList<int, string> *no_hot_spot_skiplist = NULL;
+ShardedSkipList<int, string> *sharded_skiplist = NULL;
 size_t max_number = 100;
 struct timespec start_time, end_time;
 
+/**
+    Skip list implementation the benchmarks run on
+*/
+enum Engine { LAZY, LOCK_FREE, MVCC, UNROLLED, NO_HOT_SPOT, SHARDED };
+Engine engine = LAZY;
+
+// Keys per node of the unrolled engine, set with --keys_per_node
+size_t keys_per_node = 16;
+
+// Shards of the sharded engine, set with --shards, and the keys a shard holds before it is split, set with --shard_size
+int shards = 4;
+long shard_size = 0;
+
+// Set with --finger, add and remove of the lazy skip list start from the thread's previous predecessors
+bool finger = false;
+
+// Set with --numa, benchmark threads are pinned to the NUMA nodes in turn and nodes are allocated on the node of their inserter
+bool numa = false;
+atomic<size_t> workers_started(0);
+
+// Set with --seed, seeds the level generators and the shuffles so that runs can be repeated
+unsigned long long seed = 1;
+
+// Number of keys every thread looks up to count local and remote accesses with --numa
+#define NUMA_SAMPLE 4096
+
+// Number of times every key is removed and inserted again by the churn benchmark
+#define CHURN_ROUNDS 20
+
+// Number of times every thread walks the whole bottom level in the pointer chase benchmark
+#define CHASE_ROUNDS 10
+
+// Number of times every thread reads the whole key range in the range scan benchmark
+#define SCAN_ROUNDS 10
+
+// Operations per thread and keys per scan in the snapshot scan benchmark
+#define SNAPSHOT_OPERATIONS 20000
+#define SNAPSHOT_SCAN_LENGTH 100
+
+// Number of key arrays searched by the node search benchmark, small enough to stay in cache
+#define NODE_SEARCH_NODES 256
+
 /**
     Integers to be used for operations
 */
@@ -34,7 +91,7 @@ vector<pair<int,int>> numbers_range;
 */
 void show_usage(){
 	cout << "Usage: \n\n" ;
-	cout << "./benchmark [--name] -i <max_number> -t <num_threads> --benchmark=<insert, delete, search, range, all_operations, high_contention, low_contention> [--help] \n" ;
+	cout << "./benchmark [--name] -i <max_number> -t <num_threads> --benchmark=<insert, delete, search, range, all_operations, high_contention, low_contention, churn, search_only, pointer_chase, range_scan, snapshot_scan, insert_batch, node_search> [--engine=<lazy, lock_free, mvcc, unrolled, no_hot_spot, sharded>] [--keys_per_node=<4, 8, 16, 32, 64, 128>] [--shards=<N>] [--shard_size=<S>] [--huge_pages] [--finger] [--numa] [--seed=<S>] [--help] \n" ;
 	cout << "--name                         Prints full name \n" ;
 	cout << "-i <max_number>                Numbers from 0 to max_number are inserted into skip list, subset is chosen for get, delete, and range \n" ;
 	cout << "-t <num_threads>               Max number of threads to use \n" ;
@@ -45,6 +102,27 @@ void show_usage(){
 	cout << "--benchmark=<all_operations>   Performs multithreaded all operations \n" ;
 	cout << "--benchmark=<high_contention>  Simulates high contention \n" ;
 	cout << "--benchmark=<low_contention>   Simulates low contention \n" ;
+	cout << "--benchmark=<churn>            Repeatedly removes and reinserts every key, reports peak RSS \n" ;
+	cout << "--benchmark=<search_only>      Lookups only, reports ops/sec for 1, 2, 4 ... num_threads threads \n" ;
+	cout << "--benchmark=<pointer_chase>    Walks the bottom level of a list built in random order, reports ns per hop \n" ;
+	cout << "--benchmark=<range_scan>       Reads the whole key range with range and with scan, reports keys per second \n" ;
+	cout << "--benchmark=<insert_batch>     Inserts batches of consecutive keys with add_batch and with add, reports keys per second \n" ;
+	cout << "--benchmark=<node_search>      Lower bound inside sorted nodes of 4 to 128 keys for every kernel and key width, reports ns per search \n" ;
+	cout << "--benchmark=<snapshot_scan>    Half scans read twice, half updates, reports throughput and scans that read different data \n" ;
+	cout << "--engine=<lazy>                Lock based skip list (default) \n" ;
+	cout << "--engine=<lock_free>           Lock-free skip list linked with compare and swap \n" ;
+	cout << "--engine=<mvcc>                Multi version skip list, scans read a snapshot \n" ;
+	cout << "--engine=<unrolled>            Unrolled skip list, every node holds up to keys_per_node keys \n" ;
+	cout << "--engine=<no_hot_spot>         Inserts and removes change level 0 only, a background thread rebuilds the index \n" ;
+	cout << "--engine=<sharded>             Key range split into shards, each one a lazy skip list \n" ;
+	cout << "--keys_per_node=<K>            Keys per node of the unrolled engine, default 16 \n" ;
+	cout << "--shards=<N>                   Shards of the sharded engine, equal ranges of 1 to max_number, 1 to max_number shards, default 4 \n" ;
+	cout << "--shard_size=<S>               Sharded engine splits a shard holding more than S keys, default 0 never splits \n" ;
+	cout << "--huge_pages                   Backs the node slabs with huge pages \n" ;
+	cout << "--finger                       Lazy engine starts add and remove from the thread's previous predecessors \n" ;
+	cout << "--numa                         Pins the threads to the NUMA nodes in turn, allocates nodes and index replicas per node \n" ;
+	cout << "                               and reports the local and remote accesses of a sample of keys (needs libnuma) \n" ;
+	cout << "--seed=<S>                     Seeds the levels of new nodes and the random keys, default 1 \n" ;
     cout << "--help                         Prints the usage of the program \n"; 
     cout << "\n[ max_number must be between INT_MIN and INT_MAX and exclusive of INT_MIN and INT_MAX ]\n";
 	exit(EXIT_FAILURE);
@@ -61,6 +139,395 @@ void show_elapsed_time(){
 	printf("Elapsed (s): %lf\n",elapsed_s);
 }
 
+/**
+    Display the peak resident set size of the process
+*/
+void show_peak_rss(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("Peak RSS (KB): %ld\n", usage.ru_maxrss);
+}
+
+/**
+    Unrolled skip list behind an interface, so the keys per node can be chosen at run time
+*/
+class UnrolledEngine{
+    public:
+        virtual ~UnrolledEngine(){
+        }
+        virtual bool add(int key, const string &value) = 0;
+        virtual bool remove(int key) = 0;
+        virtual string search(int key) = 0;
+        virtual bool contains(int key) = 0;
+        virtual map<int, string> range(int start_key, int end_key) = 0;
+        virtual size_t scan(int start_key, int end_key, const function<void(int, const string &)> &visitor) = 0;
+        virtual size_t size() = 0;
+};
+
+template <size_t K>
+class UnrolledEngineOf : public UnrolledEngine{
+    private:
+        UnrolledSkipList<int, string, K> list;
+    public:
+        UnrolledEngineOf(int max_elements, float probability) : list(max_elements, probability){
+        }
+        bool add(int key, const string &value){
+            return list.add(key, value);
+        }
+        bool remove(int key){
+            return list.remove(key);
+        }
+        string search(int key){
+            return list.search(key);
+        }
+        bool contains(int key){
+            return list.contains(key);
+        }
+        map<int, string> range(int start_key, int end_key){
+            return list.range(start_key, end_key);
+        }
+        size_t scan(int start_key, int end_key, const function<void(int, const string &)> &visitor){
+            return list.scan(start_key, end_key, visitor);
+        }
+        size_t size(){
+            return list.size();
+        }
+};
+
+UnrolledEngine *unrolled_skiplist = NULL;
+
+/**
+    Returns an unrolled skip list with keys_per_node keys per node, or NULL if that size is not built in
+*/
+UnrolledEngine *make_unrolled(size_t keys_per_node, int max_elements, float probability){
+    switch(keys_per_node){
+        case 4:
+            return new UnrolledEngineOf<4>(max_elements, probability);
+        case 8:
+            return new UnrolledEngineOf<8>(max_elements, probability);
+        case 16:
+            return new UnrolledEngineOf<16>(max_elements, probability);
+        case 32:
+            return new UnrolledEngineOf<32>(max_elements, probability);
+        case 64:
+            return new UnrolledEngineOf<64>(max_elements, probability);
+        case 128:
+            return new UnrolledEngineOf<128>(max_elements, probability);
+        default:
+            return NULL;
+    }
+}
+
+/**
+    Operations on the skip list selected with --engine
+*/
+void engine_init(int max_elements, float probability){
+    switch(engine){
+        case LOCK_FREE:
+            lock_free_skiplist = LockFreeSkipList(max_elements, probability);
+            break;
+        case MVCC:
+            delete mvcc_skiplist;
+            mvcc_skiplist = new MvccSkipList<int, string>(max_elements, probability);
+            break;
+        case UNROLLED:
+            delete unrolled_skiplist;
+            unrolled_skiplist = make_unrolled(keys_per_node, max_elements, probability);
+            break;
+        case NO_HOT_SPOT:
+            // Stops the maintenance thread of the previous list
+            delete no_hot_spot_skiplist;
+            no_hot_spot_skiplist = new NoHotSpotSkipList<int, string>(max_elements, probability);
+            break;
+        case SHARDED:{
+            vector<int> splits;
+            for(int i = 1; i < shards; i++){
+                splits.push_back(1 + (int) ((long long) max_number * i / shards));
+            }
+            delete sharded_skiplist;
+            sharded_skiplist = new ShardedSkipList<int, string>(splits, max_elements, probability, shard_size);
+            break;
+        }
+        default:
+            skiplist = SkipList(max_elements, probability);
+            skiplist.set_finger(finger);
+    }
+}
+
+bool engine_add(int key, string value){
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.add(key, value);
+        case MVCC:
+            return mvcc_skiplist->add(key, value);
+        case UNROLLED:
+            return unrolled_skiplist->add(key, value);
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->add(key, value);
+        case SHARDED:
+            return sharded_skiplist->add(key, value);
+        default:
+            return skiplist.add(key, value);
+    }
+}
+
+bool engine_remove(int key){
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.remove(key);
+        case MVCC:
+            return mvcc_skiplist->remove(key);
+        case UNROLLED:
+            return unrolled_skiplist->remove(key);
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->remove(key);
+        case SHARDED:
+            return sharded_skiplist->remove(key);
+        default:
+            return skiplist.remove(key);
+    }
+}
+
+string engine_search(int key){
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.search(key);
+        case MVCC:
+            return mvcc_skiplist->search(key);
+        case UNROLLED:
+            return unrolled_skiplist->search(key);
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->search(key);
+        case SHARDED:
+            return sharded_skiplist->search(key);
+        default:
+            return skiplist.search(key);
+    }
+}
+
+bool engine_contains(int key){
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.contains(key);
+        case MVCC:
+            return mvcc_skiplist->contains(key);
+        case UNROLLED:
+            return unrolled_skiplist->contains(key);
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->contains(key);
+        case SHARDED:
+            return sharded_skiplist->contains(key);
+        default:
+            return skiplist.contains(key);
+    }
+}
+
+map<int, string> engine_range(int start_key, int end_key){
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.range(start_key, end_key);
+        case MVCC:
+            return mvcc_skiplist->range(start_key, end_key);
+        case UNROLLED:
+            return unrolled_skiplist->range(start_key, end_key);
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->range(start_key, end_key);
+        case SHARDED:
+            return sharded_skiplist->range(start_key, end_key);
+        default:
+            return skiplist.range(start_key, end_key);
+    }
+}
+
+size_t engine_scan(int start_key, int end_key, long long &sum){
+    auto visitor = [&sum](int key, const string &value){ sum += key + value.size(); };
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.scan(start_key, end_key, visitor);
+        case MVCC:{
+            MvccSkipList<int, string>::Snapshot snapshot(*mvcc_skiplist);
+            return mvcc_skiplist->scan(start_key, end_key, snapshot, visitor);
+        }
+        case UNROLLED:
+            return unrolled_skiplist->scan(start_key, end_key, visitor);
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->scan(start_key, end_key, visitor);
+        case SHARDED:
+            return sharded_skiplist->scan(start_key, end_key, visitor);
+        default:
+            return skiplist.scan(start_key, end_key, visitor);
+    }
+}
+
+size_t engine_add_batch(const vector<pair<int, string> > &batch){
+    switch(engine){
+        case LAZY:
+            return skiplist.add_batch(batch);
+        default:{
+            size_t inserted = 0;
+            for(size_t i = 0; i < batch.size(); i++){
+                inserted += engine_add(batch[i].first, batch[i].second);
+            }
+            return inserted;
+        }
+    }
+}
+
+size_t engine_size(){
+    switch(engine){
+        case LOCK_FREE:
+            return lock_free_skiplist.size();
+        case MVCC:{
+            long long sum = 0;
+            return engine_scan(numeric_limits<int>::min(), numeric_limits<int>::max(), sum);
+        }
+        case UNROLLED:
+            return unrolled_skiplist->size();
+        case NO_HOT_SPOT:
+            return no_hot_spot_skiplist->size();
+        case SHARDED:
+            return sharded_skiplist->size();
+        default:
+            return skiplist.size();
+    }
+}
+
+/**
+    Reads the range twice and returns true if both reads saw the same pairs.
+    The mvcc engine reads both times from one snapshot.
+*/
+bool engine_scan_twice(int start_key, int end_key){
+    long long sums[2] = {0, 0};
+    auto first = [&sums](int key, const string &value){ sums[0] = sums[0] * 31 + key + atoi(value.c_str()); };
+    auto second = [&sums](int key, const string &value){ sums[1] = sums[1] * 31 + key + atoi(value.c_str()); };
+    switch(engine){
+        case LOCK_FREE:
+            lock_free_skiplist.scan(start_key, end_key, first);
+            lock_free_skiplist.scan(start_key, end_key, second);
+            break;
+        case MVCC:{
+            MvccSkipList<int, string>::Snapshot snapshot(*mvcc_skiplist);
+            mvcc_skiplist->scan(start_key, end_key, snapshot, first);
+            mvcc_skiplist->scan(start_key, end_key, snapshot, second);
+            break;
+        }
+        case UNROLLED:
+            unrolled_skiplist->scan(start_key, end_key, first);
+            unrolled_skiplist->scan(start_key, end_key, second);
+            break;
+        case NO_HOT_SPOT:
+            no_hot_spot_skiplist->scan(start_key, end_key, first);
+            no_hot_spot_skiplist->scan(start_key, end_key, second);
+            break;
+        case SHARDED:
+            sharded_skiplist->scan(start_key, end_key, first);
+            sharded_skiplist->scan(start_key, end_key, second);
+            break;
+        default:
+            skiplist.scan(start_key, end_key, first);
+            skiplist.scan(start_key, end_key, second);
+    }
+    return sums[0] == sums[1];
+}
+
+/**
+    Pins the calling benchmark thread to a NUMA node, the k-th thread started goes to node k modulo the number of nodes
+*/
+void pin_worker(size_t index){
+    if(numa){
+        NumaSupport::run_on_node(index % NumaSupport::num_nodes());
+    }
+}
+
+/**
+    Starts a benchmark thread running function(args...), pinned with --numa.
+    The k-th thread started draws levels from stream k, so the same seed gives every thread the same levels.
+*/
+template <typename Function, typename... Args>
+thread worker(Function function, Args... args){
+    size_t index = workers_started++;
+    return thread([=](){
+        pin_worker(index);
+        LevelGenerator::set_stream(index);
+        function(args...);
+    });
+}
+
+/**
+    Returns the address of the value stored for key, or NULL if the key is missing or the engine keeps values apart from its nodes
+*/
+const void *engine_value_address(int key){
+    const void *address = NULL;
+    auto on_found = [&address](const string &value){ address = &value; };
+    switch(engine){
+        case LAZY:
+            skiplist.search(key, on_found);
+            break;
+        case NO_HOT_SPOT:
+            no_hot_spot_skiplist->search(key, on_found);
+            break;
+        case SHARDED:
+            sharded_skiplist->search(key, on_found);
+            break;
+        default:
+            break;
+    }
+    return address;
+}
+
+/**
+    Looks up NUMA_SAMPLE random keys and counts the nodes found on the NUMA node of the thread
+*/
+void skiplist_numa_sample(unsigned int seed, size_t *local, size_t *remote){
+    vector<const void *> addresses;
+    for(size_t i = 0; i < NUMA_SAMPLE; i++){
+        const void *address = engine_value_address(numbers_insert[rand_r(&seed) % numbers_insert.size()]);
+        if(address != NULL){
+            addresses.push_back(address);
+        }
+    }
+
+    vector<int> nodes;
+    NumaSupport::nodes_of(addresses, nodes);
+    int node = NumaSupport::current_node();
+    for(size_t i = 0; i < nodes.size(); i++){
+        if(nodes[i] == node){
+            (*local)++;
+        }else if(nodes[i] >= 0){
+            (*remote)++;
+        }
+    }
+}
+
+/**
+    With --numa, samples the nodes the benchmark threads reach after the run and reports the local and remote accesses.
+    The page of every node found is looked up through libnuma.
+*/
+void show_numa_accesses(){
+    if(numbers_insert.empty() || engine_value_address(numbers_insert[0]) == NULL){
+        printf("NUMA accesses: not sampled for this benchmark and engine\n");
+        return;
+    }
+    vector<size_t> local(num_threads, 0);
+    vector<size_t> remote(num_threads, 0);
+    vector<thread> threads;
+    for(size_t i = 0; i < num_threads; i++){
+        threads.push_back(worker(skiplist_numa_sample, (unsigned int) i + 1, &local[i], &remote[i]));
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    size_t total_local = 0;
+    size_t total_remote = 0;
+    for(size_t i = 0; i < num_threads; i++){
+        total_local += local[i];
+        total_remote += remote[i];
+    }
+    printf("NUMA nodes: %d\n", NumaSupport::num_nodes());
+    printf("NUMA accesses local: %zu remote: %zu\n", total_local, total_remote);
+}
+
 void generate_input(int max_number){
     // generating insert data
     for(int i = 1; i <= max_number; i++){
@@ -87,17 +554,17 @@ void generate_input(int max_number){
 
 void skiplist_add(size_t start, size_t end){
     if(end >= numbers_insert.size()) end = numbers_insert.size();
-    if(start == end) skiplist.add(numbers_insert[start], to_string(numbers_insert[start]));
+    if(start == end) engine_add(numbers_insert[start], to_string(numbers_insert[start]));
     for(size_t i = start; i < end; i++){
-        skiplist.add(numbers_insert[i], to_string(numbers_insert[i]));
+        engine_add(numbers_insert[i], to_string(numbers_insert[i]));
     }
 }
 
 void skiplist_remove(size_t start, size_t end){
     if(end >= numbers_delete.size()) end = numbers_delete.size();
-    if(start == end) skiplist.remove(numbers_delete[start]);
+    if(start == end) engine_remove(numbers_delete[start]);
     for(size_t i = start; i < end; i++){
-        skiplist.remove(numbers_delete[i]);
+        engine_remove(numbers_delete[i]);
     }
 }
 
@@ -105,13 +572,81 @@ void skiplist_search(size_t start, size_t end){
     if(end >= numbers_get.size()) end = numbers_get.size();
     if(start == end) end++;
     for(size_t i = start; i < end; i++){
-        string s = skiplist.search(numbers_get[i]);
+        string s = engine_search(numbers_get[i]);
     }
 }
 
+void skiplist_contains(size_t start, size_t count){
+    size_t n = numbers_get.size();
+    for(size_t i = 0; i < count; i++){
+        engine_contains(numbers_get[(start + i) % n]);
+    }
+}
+
+void skiplist_churn(size_t start, size_t end){
+    if(end >= numbers_insert.size()) end = numbers_insert.size();
+    for(int round = 0; round < CHURN_ROUNDS; round++){
+        for(size_t i = start; i < end; i++){
+            engine_remove(numbers_insert[i]);
+            engine_add(numbers_insert[i], to_string(numbers_insert[i]));
+        }
+    }
+}
+
+void skiplist_chase(size_t rounds){
+    for(size_t round = 0; round < rounds; round++){
+        engine_size();
+    }
+}
+
+void skiplist_scan(int start, int end, size_t rounds, bool copy, size_t *scanned){
+    long long sum = 0;
+    for(size_t round = 0; round < rounds; round++){
+        if(copy){
+            *scanned += engine_range(start, end).size();
+        }else{
+            *scanned += engine_scan(start, end, sum);
+        }
+    }
+}
+
+void skiplist_snapshot_scan(unsigned int seed, size_t *scans, size_t *updates, size_t *inconsistent){
+    for(size_t i = 0; i < SNAPSHOT_OPERATIONS; i++){
+        int key = 1 + rand_r(&seed) % max_number;
+        if(rand_r(&seed) % 2 == 0){
+            if(!engine_scan_twice(key, key + SNAPSHOT_SCAN_LENGTH - 1)){
+                (*inconsistent)++;
+            }
+            (*scans)++;
+        }else{
+            if(engine_remove(key) || rand_r(&seed) % 2 == 0){
+                engine_add(key, to_string(rand_r(&seed)));
+            }
+            (*updates)++;
+        }
+    }
+}
+
+void skiplist_add_batches(const vector<size_t> *batch_starts, size_t first, size_t step, size_t batch_size, bool batched){
+    vector<pair<int, string> > batch;
+    for(size_t b = first; b < batch_starts->size(); b += step){
+        size_t start = (*batch_starts)[b];
+        batch.clear();
+        for(size_t j = start; j < numbers_insert.size() && j < start + batch_size; j++){
+            batch.push_back(make_pair(numbers_insert[j], to_string(numbers_insert[j])));
+        }
+        if(batched){
+            engine_add_batch(batch);
+        }else{
+            for(size_t j = 0; j < batch.size(); j++){
+                engine_add(batch[j].first, batch[j].second);
+            }
+        }
+    }
+}
 
 void skiplist_range(int start, int end){
-    map<int, string> range_output = skiplist.range(start, end);
+    map<int, string> range_output = engine_range(start, end);
 }
 
 void insert_benchmark(){
@@ -120,7 +655,7 @@ void insert_benchmark(){
     // insert
     int chunk_size = ceil(float(numbers_insert.size()) / num_threads);
     for(size_t i = 0; i < numbers_insert.size(); i = i + chunk_size){
-        threads.push_back(thread(skiplist_add, i, i+chunk_size));
+        threads.push_back(worker(skiplist_add, i, i+chunk_size));
     }
     for (auto &th : threads) {
         th.join();
@@ -135,7 +670,7 @@ void delete_benchmark(){
     // delete
     int chunk_size = ceil(float(numbers_delete.size()) / num_threads);
     for(size_t i = 0; i < numbers_delete.size(); i = i + chunk_size){
-        threads.push_back(thread(skiplist_remove, i, i+chunk_size));
+        threads.push_back(worker(skiplist_remove, i, i+chunk_size));
     }
     for (auto &th : threads) {
         th.join();
@@ -151,7 +686,7 @@ void search_benchmark(){
     // search
     int chunk_size = ceil(float(numbers_get.size()) / num_threads);
     for(size_t i = 0; i < numbers_get.size(); i = i + chunk_size){
-        threads.push_back(thread(skiplist_search, i, i+chunk_size));
+        threads.push_back(worker(skiplist_search, i, i+chunk_size));
     }
     for (auto &th : threads) {
         th.join();
@@ -165,7 +700,7 @@ void range_benchmark(){
 
     // range
     for(size_t i = 0; i < num_threads; i++){
-        threads.push_back(thread(skiplist_range, numbers_range[i].first, numbers_range[i].second));
+        threads.push_back(worker(skiplist_range, numbers_range[i].first, numbers_range[i].second));
     }
     for (auto &th : threads) {
         th.join();
@@ -175,6 +710,231 @@ void range_benchmark(){
 
 }
 
+/**
+    Every thread looks up all the keys once, starting from a different offset.
+    Runs with 1, 2, 4 ... num_threads threads and reports the throughput of each.
+*/
+void search_only_benchmark(){
+    vector<size_t> thread_counts;
+    for(size_t t = 1; t < num_threads; t = t * 2){
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(num_threads);
+
+    size_t n = numbers_get.size();
+    for(size_t t : thread_counts){
+        vector<thread> threads;
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        for(size_t i = 0; i < t; i++){
+            threads.push_back(worker(skiplist_contains, i * n / t, n));
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+        clock_gettime(CLOCK_MONOTONIC,&end);
+
+        double elapsed_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+        double ops = double(t * n) / elapsed_s;
+        printf("Threads: %zu  Ops/sec: %.0f  Ops/sec per thread: %.0f\n", t, ops, ops / t);
+    }
+}
+
+/**
+    Keeps the live set constant while every thread removes and reinserts its chunk of keys.
+    Memory should stay proportional to the live keys since removed nodes are reclaimed.
+*/
+void churn_benchmark(){
+    vector<thread> threads;
+
+    int chunk_size = ceil(float(numbers_insert.size()) / num_threads);
+    for(size_t i = 0; i < numbers_insert.size(); i = i + chunk_size){
+        threads.push_back(worker(skiplist_churn, i, i+chunk_size));
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    threads.clear();
+}
+
+/**
+    Inserts the keys in random order, so neighbours on the bottom level are not neighbours in memory,
+    then every thread walks the bottom level CHASE_ROUNDS times. Reports the average time of one hop.
+*/
+void pointer_chase_benchmark(){
+    random_shuffle(numbers_insert.begin(), numbers_insert.end());
+    insert_benchmark();
+
+    vector<thread> threads;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    for(size_t i = 0; i < num_threads; i++){
+        threads.push_back(worker(skiplist_chase, CHASE_ROUNDS));
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+    clock_gettime(CLOCK_MONOTONIC,&end);
+
+    double elapsed_ns = (end.tv_sec - start.tv_sec) * 1000000000.0 + (end.tv_nsec - start.tv_nsec);
+    double hops = double(num_threads) * CHASE_ROUNDS * (numbers_insert.size() + 1);
+    printf("Hops: %.0f  ns/hop: %.2f\n", hops, elapsed_ns * num_threads / hops);
+}
+
+/**
+    Every thread reads all the keys SCAN_ROUNDS times, first copying them into a map with range
+    and then visiting them in place with scan. Reports the keys read per second for both.
+*/
+void range_scan_benchmark(){
+    const char *names[] = {"range", "scan"};
+    for(int copy = 1; copy >= 0; copy--){
+        vector<thread> threads;
+        vector<size_t> scanned(num_threads, 0);
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        for(size_t i = 0; i < num_threads; i++){
+            threads.push_back(worker(skiplist_scan, 1, (int) max_number, SCAN_ROUNDS, copy == 1, &scanned[i]));
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+        clock_gettime(CLOCK_MONOTONIC,&end);
+
+        size_t keys = 0;
+        for(size_t i = 0; i < num_threads; i++){
+            keys += scanned[i];
+        }
+        double elapsed_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+        printf("%s  Keys: %zu  Keys/sec: %.0f\n", names[1 - copy], keys, keys / elapsed_s);
+    }
+}
+
+/**
+    Every thread runs SNAPSHOT_OPERATIONS operations, half of them scans of SNAPSHOT_SCAN_LENGTH keys and
+    half updates that remove a key and insert it again with a new value. Every scan reads its range twice,
+    reads that differ show a scan that does not see a consistent state.
+*/
+void snapshot_scan_benchmark(){
+    vector<thread> threads;
+    vector<size_t> scans(num_threads, 0), updates(num_threads, 0), inconsistent(num_threads, 0);
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    for(size_t i = 0; i < num_threads; i++){
+        threads.push_back(worker(skiplist_snapshot_scan, (unsigned int) i + 1, &scans[i], &updates[i], &inconsistent[i]));
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+    clock_gettime(CLOCK_MONOTONIC,&end);
+
+    size_t total_scans = 0, total_updates = 0, total_inconsistent = 0;
+    for(size_t i = 0; i < num_threads; i++){
+        total_scans += scans[i];
+        total_updates += updates[i];
+        total_inconsistent += inconsistent[i];
+    }
+    double elapsed_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+    printf("Scans/sec: %.0f  Updates/sec: %.0f  Inconsistent scans: %zu of %zu\n",
+            total_scans / elapsed_s, total_updates / elapsed_s, total_inconsistent, total_scans);
+}
+
+/**
+    Splits the keys into batches of consecutive keys and inserts the batches in random order, spread over the threads.
+    Every batch size is run once with add_batch and once key by key with add, into a new list each time.
+    Reports the keys inserted per second.
+*/
+void insert_batch_benchmark(){
+    size_t batch_sizes[] = {16, 256, 4096};
+    const char *names[] = {"add", "add_batch"};
+
+    for(size_t batch_size : batch_sizes){
+        vector<size_t> batch_starts;
+        for(size_t i = 0; i < numbers_insert.size(); i += batch_size){
+            batch_starts.push_back(i);
+        }
+        random_shuffle(batch_starts.begin(), batch_starts.end());
+
+        for(int batched = 0; batched <= 1; batched++){
+            engine_init(numbers_insert.size(), 0.5);
+
+            vector<thread> threads;
+            struct timespec start, end;
+
+            clock_gettime(CLOCK_MONOTONIC,&start);
+            for(size_t i = 0; i < num_threads; i++){
+                threads.push_back(worker(skiplist_add_batches, &batch_starts, i, num_threads, batch_size, batched == 1));
+            }
+            for (auto &th : threads) {
+                th.join();
+            }
+            clock_gettime(CLOCK_MONOTONIC,&end);
+
+            double elapsed_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+            printf("Batch size: %zu  %s  Keys/sec: %.0f\n", batch_size, names[batched], numbers_insert.size() / elapsed_s);
+        }
+    }
+}
+
+/**
+    Searches max_number random keys in nodes of K sorted keys of one width with the current kernel.
+    Returns the time per search in ns.
+*/
+template <typename Key>
+double node_search_ns(size_t keys_per_node){
+    vector<Key> keys(NODE_SEARCH_NODES * keys_per_node);
+    for(size_t i = 0; i < keys.size(); i++){
+        keys[i] = (Key)(rand() % 1000000);
+    }
+    for(size_t node = 0; node < NODE_SEARCH_NODES; node++){
+        sort(keys.begin() + node * keys_per_node, keys.begin() + (node + 1) * keys_per_node);
+    }
+    vector<Key> needles(max_number);
+    for(size_t i = 0; i < needles.size(); i++){
+        needles[i] = (Key)(rand() % 1000000);
+    }
+
+    struct timespec start, end;
+    size_t sum = 0;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    for(size_t i = 0; i < needles.size(); i++){
+        sum += KeySearch::lower_bound(&keys[(i % NODE_SEARCH_NODES) * keys_per_node], keys_per_node, needles[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC,&end);
+
+    // Keeps the searches from being optimized away
+    if(sum == (size_t)-1){
+        printf("\n");
+    }
+    double elapsed_ns = (end.tv_sec - start.tv_sec) * 1000000000.0 + (end.tv_nsec - start.tv_nsec);
+    return elapsed_ns / needles.size();
+}
+
+/**
+    Compares the lower bound kernels inside a node, without any traversal, for 32 and 64 bit keys.
+    Reports the time per search for every node size and every kernel the processor supports.
+*/
+void node_search_benchmark(){
+    size_t sizes[] = {4, 8, 16, 32, 64, 128};
+    KeySearch::Kernel kernels[] = {KeySearch::SCALAR, KeySearch::SSE4, KeySearch::AVX2};
+    KeySearch::Kernel best = KeySearch::get_kernel();
+
+    for(KeySearch::Kernel kernel : kernels){
+        if(!KeySearch::set_kernel(kernel)){
+            continue;
+        }
+        for(size_t keys_per_node : sizes){
+            printf("Kernel: %s  Keys per node: %zu  32 bit ns/search: %.2f  64 bit ns/search: %.2f\n", KeySearch::kernel_name(kernel),
+                keys_per_node, node_search_ns<int32_t>(keys_per_node), node_search_ns<int64_t>(keys_per_node));
+        }
+    }
+    KeySearch::set_kernel(best);
+}
+
 void skiplist_combined_operations(){
 
     int start = (rand() % static_cast<int>(numbers_insert.size() + 1));
@@ -199,7 +959,7 @@ void concurrent_skiplist_combined(){
     vector<thread> threads;
 
     for(size_t i = 0; i < num_threads; i++){
-        threads.push_back(thread(skiplist_combined_operations));
+        threads.push_back(worker(skiplist_combined_operations));
     }
     for (auto &th : threads) {
         th.join();
@@ -214,22 +974,22 @@ void all_operations_benchmark(){
 void high_contention_benchmark_thread(){
 
     for(size_t i = 0; i < max_number; i++){
-        skiplist.add(3 , "3");
-        skiplist.remove(3);
+        engine_add(3 , "3");
+        engine_remove(3);
     }
 
 }
 
 void high_contention_benchmark(){   
-    skiplist = SkipList(3, 0.5);
+    engine_init(3, 0.5);
 
-    skiplist.add(1, "1");
-    skiplist.add(2, "2");
+    engine_add(1, "1");
+    engine_add(2, "2");
 
     vector<thread> threads;
 
     for(size_t i = 0; i < num_threads; i++){
-        threads.push_back(thread(high_contention_benchmark_thread));
+        threads.push_back(worker(high_contention_benchmark_thread));
     }
     for (auto &th : threads) {
         th.join();
@@ -245,12 +1005,12 @@ void low_contention_benchmark(){
         numbers_insert.push_back(i);
     }
 
-    skiplist = SkipList(numbers_insert.size(), 0.5);
+    engine_init(numbers_insert.size(), 0.5);
 
     // insert
     int chunk_size = ceil(float(numbers_insert.size()) / num_threads);
     for(size_t i = 0; i < numbers_insert.size(); i = i + chunk_size){
-        threads.push_back(thread(skiplist_add, i, i+chunk_size));
+        threads.push_back(worker(skiplist_add, i, i+chunk_size));
     }
     for (auto &th : threads) {
         th.join();
@@ -268,6 +1028,14 @@ int main(int argc, char *argv[]){
     static struct option long_options[] = {
         {"name", no_argument, NULL, 'n'},
         {"benchmark", required_argument, NULL, 'b'},
+        {"engine", required_argument, NULL, 'e'},
+        {"keys_per_node", required_argument, NULL, 'k'},
+        {"huge_pages", no_argument, NULL, 'g'},
+        {"finger", no_argument, NULL, 'f'},
+        {"numa", no_argument, NULL, 'u'},
+        {"shards", required_argument, NULL, 's'},
+        {"shard_size", required_argument, NULL, 'z'},
+        {"seed", required_argument, NULL, 'r'},
         {"help", no_argument, NULL, 'h'},
         {0, 0, 0, 0}
     };
@@ -291,6 +1059,59 @@ int main(int argc, char *argv[]){
             case 'b':
                 benchmark = std::string(optarg);
                 break;
+            case 'e':
+                if(string(optarg) == "lock_free"){
+                    engine = LOCK_FREE;
+                }else if(string(optarg) == "mvcc"){
+                    engine = MVCC;
+                }else if(string(optarg) == "unrolled"){
+                    engine = UNROLLED;
+                }else if(string(optarg) == "no_hot_spot"){
+                    engine = NO_HOT_SPOT;
+                }else if(string(optarg) == "sharded"){
+                    engine = SHARDED;
+                }else if(string(optarg) == "lazy"){
+                    engine = LAZY;
+                }else{
+                    cout << "Invalid engine type \n";
+                    help = true;
+                }
+                break;
+            case 'k':{
+                keys_per_node = stoi(optarg);
+                UnrolledEngine *probe = make_unrolled(keys_per_node, 1, 0.5);
+                if(probe == NULL){
+                    cout << "Invalid keys per node \n";
+                    help = true;
+                }
+                delete probe;
+                break;
+            }
+            case 'g':
+                NodeAllocator::set_huge_pages(true);
+                break;
+            case 'f':
+                finger = true;
+                break;
+            case 's':
+                shards = stoi(optarg);
+                if(shards < 1){
+                    cout << "Invalid shard count \n";
+                    help = true;
+                }
+                break;
+            case 'z':
+                shard_size = stol(optarg);
+                break;
+            case 'u':
+                numa = NumaSupport::set_enabled(true);
+                if(!numa){
+                    cout << "libnuma is not available, --numa is ignored \n";
+                }
+                break;
+            case 'r':
+                seed = stoull(optarg);
+                break;
             case 'h':
                 help = true;
                 break;
@@ -315,35 +1136,42 @@ int main(int argc, char *argv[]){
         show_usage();
     }
 
+    LevelGenerator::set_seed(seed);
+    srand((unsigned int) seed);
+
 	if(argc > 2){
-	    if(benchmark == "" || max_number <= 0 || num_threads < 1 ){
+	    if((size_t) shards > max_number){
+	        // Equal ranges of fewer than one key would repeat a split
+	        cout << "Invalid shard count, at most max_number shards \n";
+	        show_usage();
+	    }else if(benchmark == "" || max_number <= 0 || num_threads < 1 ){
 	        show_usage();
 	    }else{
 
 	        if(benchmark == "insert"){
                 generate_input(max_number);
-                skiplist = SkipList(numbers_insert.size(), 0.5);
+                engine_init(numbers_insert.size(), 0.5);
                 clock_gettime(CLOCK_MONOTONIC,&start_time);
                 insert_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&end_time);
 	        }
 	        else if (benchmark == "delete"){
                 generate_input(max_number);
-                skiplist = SkipList(numbers_insert.size(), 0.5);
+                engine_init(numbers_insert.size(), 0.5);
                 insert_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&start_time);
                 delete_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&end_time);
 	        }else if (benchmark == "search"){
                 generate_input(max_number);
-                skiplist = SkipList(numbers_insert.size(), 0.5);
+                engine_init(numbers_insert.size(), 0.5);
                 insert_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&start_time);
                 search_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&end_time);
 	        }else if (benchmark == "range"){
                 generate_input(max_number);
-                skiplist = SkipList(numbers_insert.size(), 0.5);
+                engine_init(numbers_insert.size(), 0.5);
                 insert_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&start_time);
                 range_benchmark();
@@ -351,7 +1179,7 @@ int main(int argc, char *argv[]){
 	        }
             else if (benchmark == "all_operations"){
                 generate_input(max_number);
-                skiplist = SkipList(numbers_insert.size(), 0.5);
+                engine_init(numbers_insert.size(), 0.5);
                 clock_gettime(CLOCK_MONOTONIC,&start_time);
                 all_operations_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&end_time);
@@ -363,11 +1191,60 @@ int main(int argc, char *argv[]){
                 clock_gettime(CLOCK_MONOTONIC,&start_time);
                 low_contention_benchmark();
                 clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "search_only"){
+                generate_input(max_number);
+                engine_init(numbers_insert.size(), 0.5);
+                insert_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                search_only_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "pointer_chase"){
+                generate_input(max_number);
+                engine_init(numbers_insert.size(), 0.5);
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                pointer_chase_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "range_scan"){
+                generate_input(max_number);
+                engine_init(numbers_insert.size(), 0.5);
+                insert_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                range_scan_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "snapshot_scan"){
+                generate_input(max_number);
+                engine_init(numbers_insert.size(), 0.5);
+                insert_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                snapshot_scan_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "insert_batch"){
+                generate_input(max_number);
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                insert_batch_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "node_search"){
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                node_search_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
+	        }else if (benchmark == "churn"){
+                generate_input(max_number);
+                engine_init(numbers_insert.size(), 0.5);
+                insert_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&start_time);
+                churn_benchmark();
+                clock_gettime(CLOCK_MONOTONIC,&end_time);
 	        }else{
 	            cout << "Invalid benchmark type \n";
 	            show_usage();
 	        }
             show_elapsed_time();
+            if(benchmark == "churn"){
+                show_peak_rss();
+            }
+            if(numa){
+                show_numa_accesses();
+            }
 	    }
     }else{
         show_usage();
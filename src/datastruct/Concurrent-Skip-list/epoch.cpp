@@ -0,0 +1,230 @@
+/**
+    Epoch based memory reclamation.
+    Every thread owns a record holding the epoch it entered in and three limbo lists of retired objects.
+    The global epoch only advances when all the threads inside an epoch have observed the current one,
+    so objects retired two epochs ago can no longer be referenced by anyone and are freed.
+*/
+
+#include <stdlib.h>
+#include <thread>
+#include "epoch.h"
+
+// Number of limbo lists kept by each thread, one per epoch modulo EPOCH_COUNT
+#define EPOCH_COUNT 3
+
+/**
+    An object waiting to be freed along with the function that frees it
+*/
+struct Retired{
+    void *object;
+    void (*deleter)(void *);
+};
+
+struct EpochManager::ThreadRecord{
+    // Epoch the thread entered in, shifted left by one. The lowest bit is set while the thread is inside an epoch
+    atomic<uint64_t> state;
+
+    // Set while a live thread owns this record
+    atomic<bool> in_use;
+
+    // Depth of nested guards of the owning thread
+    int nesting;
+
+    // Objects retired since the last attempt to reclaim
+    size_t retired_since_reclaim;
+
+    // Retired objects and the epoch in which they were retired
+    vector<Retired> limbo[EPOCH_COUNT];
+    uint64_t limbo_epoch[EPOCH_COUNT];
+
+    // Next record in the global list of records
+    ThreadRecord *next;
+
+    // Keeps the records of different threads on different cache lines
+    char padding[64];
+
+    ThreadRecord() : state(0), in_use(true), nesting(0), retired_since_reclaim(0), next(NULL){
+        for (int i = 0; i < EPOCH_COUNT; i++){
+            limbo_epoch[i] = 0;
+        }
+    }
+};
+
+static atomic<uint64_t> global_epoch(EPOCH_COUNT);
+static atomic<EpochManager::ThreadRecord *> records(NULL);
+
+/**
+    Frees every object in a limbo list
+*/
+static void free_limbo(vector<Retired> &limbo){
+    for (size_t i = 0; i < limbo.size(); i++){
+        limbo[i].deleter(limbo[i].object);
+    }
+    limbo.clear();
+}
+
+/**
+    Frees the limbo lists of the record that no thread can reference anymore
+*/
+static void free_expired(EpochManager::ThreadRecord *record){
+    uint64_t epoch = global_epoch.load();
+    for (int i = 0; i < EPOCH_COUNT; i++){
+        if (!record->limbo[i].empty() && record->limbo_epoch[i] + 2 <= epoch){
+            free_limbo(record->limbo[i]);
+        }
+    }
+}
+
+/**
+    Advances the global epoch if every thread inside an epoch has observed the current one
+*/
+static void try_advance(){
+    uint64_t epoch = global_epoch.load();
+    for (EpochManager::ThreadRecord *r = records.load(); r != NULL; r = r->next){
+        uint64_t state = r->state.load();
+        if ((state & 1) && (state >> 1) != epoch){
+            return;
+        }
+    }
+    global_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+/**
+    Takes ownership of an unused record, or allocates and publishes a new one
+*/
+static EpochManager::ThreadRecord *acquire_record(){
+    for (EpochManager::ThreadRecord *r = records.load(); r != NULL; r = r->next){
+        bool expected = false;
+        if (!r->in_use.load() && r->in_use.compare_exchange_strong(expected, true)){
+            return r;
+        }
+    }
+
+    EpochManager::ThreadRecord *record = new EpochManager::ThreadRecord();
+    EpochManager::ThreadRecord *head = records.load();
+    do{
+        record->next = head;
+    }while(!records.compare_exchange_weak(head, record));
+    return record;
+}
+
+/**
+    Owns the record of a thread and hands it back when the thread exits.
+    Objects that are still unsafe to free stay in the record and are freed by the next owner.
+*/
+struct RecordHandle{
+    EpochManager::ThreadRecord *record;
+
+    RecordHandle() : record(NULL){
+    }
+
+    ~RecordHandle(){
+        if (record != NULL){
+            try_advance();
+            free_expired(record);
+            record->in_use.store(false);
+        }
+    }
+};
+
+static thread_local RecordHandle handle;
+
+static inline EpochManager::ThreadRecord *get_record(){
+    if (handle.record == NULL){
+        handle.record = acquire_record();
+    }
+    return handle.record;
+}
+
+/**
+    Enters the current epoch. Nodes reachable from here on are not freed until exit is called.
+*/
+void EpochManager::enter(){
+    ThreadRecord *record = get_record();
+    if (record->nesting++ > 0){
+        return;
+    }
+    // The epoch may advance before the state is visible, so publish until the two agree
+    uint64_t epoch = global_epoch.load();
+    while (true){
+        record->state.store((epoch << 1) | 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t current = global_epoch.load();
+        if (current == epoch){
+            break;
+        }
+        epoch = current;
+    }
+}
+
+/**
+    Exits the epoch entered by the matching call to enter
+*/
+void EpochManager::exit(){
+    ThreadRecord *record = get_record();
+    if (--record->nesting > 0){
+        return;
+    }
+    record->state.store(record->state.load(memory_order_relaxed) & ~(uint64_t)1, memory_order_release);
+}
+
+/**
+    Hands an unlinked object over to the reclaimer. The deleter is called once no thread can reference it.
+*/
+void EpochManager::retire(void *object, void (*deleter)(void *)){
+    ThreadRecord *record = get_record();
+    uint64_t epoch = global_epoch.load();
+    int slot = epoch % EPOCH_COUNT;
+
+    // The list still holds objects from at least EPOCH_COUNT epochs ago, which are safe to free
+    if (record->limbo_epoch[slot] != epoch){
+        free_limbo(record->limbo[slot]);
+        record->limbo_epoch[slot] = epoch;
+    }
+
+    Retired retired = {object, deleter};
+    record->limbo[slot].push_back(retired);
+
+    if (++record->retired_since_reclaim >= RECLAIM_THRESHOLD){
+        reclaim();
+    }
+}
+
+/**
+    Tries to advance the epoch and frees the objects of the calling thread that are no longer reachable
+*/
+void EpochManager::reclaim(){
+    ThreadRecord *record = get_record();
+    record->retired_since_reclaim = 0;
+    try_advance();
+    free_expired(record);
+}
+
+/**
+    Waits until every thread that was inside an epoch when it was called has left it.
+    Must be called outside an epoch, or the epoch could never advance far enough.
+*/
+void EpochManager::synchronize(){
+    uint64_t target = global_epoch.load() + 2;
+    while (global_epoch.load() < target){
+        try_advance();
+        if (global_epoch.load() < target){
+            this_thread::yield();
+        }
+    }
+}
+
+/**
+    Returns the global epoch
+*/
+uint64_t EpochManager::get_epoch(){
+    return global_epoch.load();
+}
+
+/**
+    Returns the epoch the calling thread entered in. Only meaningful inside an epoch.
+    Nodes reachable during an epoch are not freed before any later entry into the same epoch exits.
+*/
+uint64_t EpochManager::get_entered_epoch(){
+    return get_record()->state.load(memory_order_relaxed) >> 1;
+}
@@ -0,0 +1,63 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+    Epoch based memory reclamation shared by all the skip lists in the process.
+    Operations enter and exit an epoch around every traversal, and removed nodes are retired instead of deleted.
+    A retired object is freed only once every thread that could still hold a reference to it has left its epoch.
+*/
+class EpochManager{
+    public:
+        // Number of objects a thread retires before it tries to advance the epoch and free its old objects
+        static const size_t RECLAIM_THRESHOLD = 64;
+
+        static void enter();
+        static void exit();
+        static void retire(void *object, void (*deleter)(void *));
+        static void reclaim();
+        static void synchronize();
+        static uint64_t get_epoch();
+        static uint64_t get_entered_epoch();
+
+        /**
+            Retires an object allocated with new. It is deleted once no thread can reference it.
+        */
+        template <typename T>
+        static void retire(T *object){
+            retire(static_cast<void *>(object), &delete_object<T>);
+        }
+
+        // Per thread bookkeeping, defined in epoch.cpp
+        struct ThreadRecord;
+
+    private:
+        template <typename T>
+        static void delete_object(void *object){
+            delete static_cast<T *>(object);
+        }
+};
+
+/**
+    Keeps the calling thread inside an epoch for the lifetime of the guard.
+    Guards can be nested, only the outermost one enters and exits the epoch.
+*/
+class EpochGuard{
+    public:
+        EpochGuard(){
+            EpochManager::enter();
+        }
+        ~EpochGuard(){
+            EpochManager::exit();
+        }
+    private:
+        EpochGuard(const EpochGuard &);
+        EpochGuard &operator=(const EpochGuard &);
+};
+
+#endif
@@ -0,0 +1,217 @@
+/**
+    Vectorized lower bound kernels with a scalar fallback, selected at run time
+*/
+
+#include <atomic>
+#include "key_search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KEY_SEARCH_X86
+#endif
+
+typedef size_t (*LowerBound32)(const int32_t *, size_t, int32_t);
+typedef size_t (*LowerBound64)(const int64_t *, size_t, int64_t);
+
+template <typename Key>
+static size_t lower_bound_scalar(const Key *keys, size_t count, Key key){
+    size_t i = 0;
+    while(i < count && keys[i] < key){
+        i++;
+    }
+    return i;
+}
+
+#ifdef KEY_SEARCH_X86
+
+/**
+    The keys are sorted, so the lower bound is the number of keys less than key.
+    Every kernel compares key with a whole vector of keys at a time and adds up the lanes holding a smaller key,
+    without a branch that depends on the keys. The keys after the last whole vector go to the narrower kernel.
+*/
+__attribute__((target("sse4.2")))
+static size_t lower_bound_sse4_32(const int32_t *keys, size_t count, int32_t key){
+    const __m128i needle = _mm_set1_epi32(key);
+    __m128i less = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4){
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        less = _mm_sub_epi32(less, _mm_cmpgt_epi32(needle, block));
+    }
+    less = _mm_add_epi32(less, _mm_shuffle_epi32(less, _MM_SHUFFLE(1, 0, 3, 2)));
+    less = _mm_add_epi32(less, _mm_shuffle_epi32(less, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(less) + lower_bound_scalar(keys + i, count - i, key);
+}
+
+__attribute__((target("sse4.2")))
+static size_t lower_bound_sse4_64(const int64_t *keys, size_t count, int64_t key){
+    const __m128i needle = _mm_set1_epi64x(key);
+    __m128i less = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2){
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        less = _mm_sub_epi64(less, _mm_cmpgt_epi64(needle, block));
+    }
+    less = _mm_add_epi64(less, _mm_unpackhi_epi64(less, less));
+    return _mm_cvtsi128_si64(less) + lower_bound_scalar(keys + i, count - i, key);
+}
+
+__attribute__((target("avx2")))
+static size_t lower_bound_avx2_32(const int32_t *keys, size_t count, int32_t key){
+    const __m256i needle = _mm256_set1_epi32(key);
+    __m256i less = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8){
+        __m256i block = _mm256_loadu_si256((const __m256i *)(keys + i));
+        less = _mm256_sub_epi32(less, _mm256_cmpgt_epi32(needle, block));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(less), _mm256_extracti128_si256(less, 1));
+    if(i + 4 <= count){
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        half = _mm_sub_epi32(half, _mm_cmpgt_epi32(_mm256_castsi256_si128(needle), block));
+        i += 4;
+    }
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    size_t lower = _mm_cvtsi128_si32(half);
+
+    // Leaves the upper halves clean so that the legacy SSE code of the caller runs at full speed
+    _mm256_zeroupper();
+    return lower + lower_bound_scalar(keys + i, count - i, key);
+}
+
+__attribute__((target("avx2")))
+static size_t lower_bound_avx2_64(const int64_t *keys, size_t count, int64_t key){
+    const __m256i needle = _mm256_set1_epi64x(key);
+    __m256i less = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4){
+        __m256i block = _mm256_loadu_si256((const __m256i *)(keys + i));
+        less = _mm256_sub_epi64(less, _mm256_cmpgt_epi64(needle, block));
+    }
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(less), _mm256_extracti128_si256(less, 1));
+    if(i + 2 <= count){
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        half = _mm_sub_epi64(half, _mm_cmpgt_epi64(_mm256_castsi256_si128(needle), block));
+        i += 2;
+    }
+    half = _mm_add_epi64(half, _mm_unpackhi_epi64(half, half));
+    size_t lower = _mm_cvtsi128_si64(half);
+
+    _mm256_zeroupper();
+    return lower + lower_bound_scalar(keys + i, count - i, key);
+}
+
+#endif
+
+/**
+    Returns true if the processor runs the kernel
+*/
+static bool supported(KeySearch::Kernel kernel){
+#ifdef KEY_SEARCH_X86
+    __builtin_cpu_init();
+    switch(kernel){
+        case KeySearch::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case KeySearch::SSE4:
+            return __builtin_cpu_supports("sse4.2");
+        default:
+            return true;
+    }
+#else
+    return kernel == KeySearch::SCALAR;
+#endif
+}
+
+static KeySearch::Kernel best_kernel(){
+    if(supported(KeySearch::AVX2)){
+        return KeySearch::AVX2;
+    }
+    if(supported(KeySearch::SSE4)){
+        return KeySearch::SSE4;
+    }
+    return KeySearch::SCALAR;
+}
+
+static size_t resolve_32(const int32_t *keys, size_t count, int32_t key);
+static size_t resolve_64(const int64_t *keys, size_t count, int64_t key);
+
+// Kernels in use. They start at a resolver that installs the best kernel on the first call
+static atomic<LowerBound32> kernel_32(resolve_32);
+static atomic<LowerBound64> kernel_64(resolve_64);
+static atomic<KeySearch::Kernel> current(KeySearch::SCALAR);
+static atomic<bool> resolved(false);
+
+static void install(KeySearch::Kernel kernel){
+    switch(kernel){
+#ifdef KEY_SEARCH_X86
+        case KeySearch::AVX2:
+            kernel_32.store(lower_bound_avx2_32, memory_order_relaxed);
+            kernel_64.store(lower_bound_avx2_64, memory_order_relaxed);
+            break;
+        case KeySearch::SSE4:
+            kernel_32.store(lower_bound_sse4_32, memory_order_relaxed);
+            kernel_64.store(lower_bound_sse4_64, memory_order_relaxed);
+            break;
+#endif
+        default:
+            kernel_32.store(lower_bound_scalar<int32_t>, memory_order_relaxed);
+            kernel_64.store(lower_bound_scalar<int64_t>, memory_order_relaxed);
+    }
+    current.store(kernel, memory_order_relaxed);
+    resolved.store(true, memory_order_release);
+}
+
+static void resolve(){
+    if(!resolved.load(memory_order_acquire)){
+        install(best_kernel());
+    }
+}
+
+static size_t resolve_32(const int32_t *keys, size_t count, int32_t key){
+    resolve();
+    return kernel_32.load(memory_order_relaxed)(keys, count, key);
+}
+
+static size_t resolve_64(const int64_t *keys, size_t count, int64_t key){
+    resolve();
+    return kernel_64.load(memory_order_relaxed)(keys, count, key);
+}
+
+size_t KeySearch::lower_bound(const int32_t *keys, size_t count, int32_t key){
+    return kernel_32.load(memory_order_relaxed)(keys, count, key);
+}
+
+size_t KeySearch::lower_bound(const int64_t *keys, size_t count, int64_t key){
+    return kernel_64.load(memory_order_relaxed)(keys, count, key);
+}
+
+/**
+    Returns the kernel lower_bound uses
+*/
+KeySearch::Kernel KeySearch::get_kernel(){
+    resolve();
+    return current.load(memory_order_relaxed);
+}
+
+/**
+    Makes lower_bound use a kernel the processor supports, used to compare the kernels
+*/
+bool KeySearch::set_kernel(Kernel kernel){
+    if(!supported(kernel)){
+        return false;
+    }
+    install(kernel);
+    return true;
+}
+
+const char *KeySearch::kernel_name(Kernel kernel){
+    switch(kernel){
+        case AVX2:
+            return "avx2";
+        case SSE4:
+            return "sse4";
+        default:
+            return "scalar";
+    }
+}
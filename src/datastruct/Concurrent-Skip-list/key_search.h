@@ -0,0 +1,63 @@
+#ifndef KEY_SEARCH_H
+#define KEY_SEARCH_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+    Lower bound kernels for the sorted key arrays of unrolled nodes.
+    A kernel compares the key with a whole vector of node keys at once and stops at the first vector
+    holding a key that is not before it. The kernel is chosen once from the instructions the processor
+    reports through CPUID: AVX2, else SSE4.2, else a scalar loop.
+*/
+class KeySearch{
+    public:
+        enum Kernel { SCALAR, SSE4, AVX2 };
+
+        // Returns the index of the first of the count keys that is not less than key, or count
+        static size_t lower_bound(const int32_t *keys, size_t count, int32_t key);
+        static size_t lower_bound(const int64_t *keys, size_t count, int64_t key);
+
+        static Kernel get_kernel();
+
+        // Makes lower_bound use a kernel, returns false and keeps the current one if the processor lacks it
+        static bool set_kernel(Kernel kernel);
+
+        static const char *kernel_name(Kernel kernel);
+};
+
+/**
+    Lower bound inside a node for any key type and order, a scalar scan of the keys
+*/
+template <typename Key, typename Compare>
+struct NodeSearch{
+    static size_t lower_bound(const Key *keys, size_t count, const Key &key, const Compare &compare){
+        size_t i = 0;
+        while(i < count && compare(keys[i], key)){
+            i++;
+        }
+        return i;
+    }
+};
+
+/**
+    Integer keys in ascending order use the vector kernels
+*/
+template <>
+struct NodeSearch<int32_t, less<int32_t> >{
+    static size_t lower_bound(const int32_t *keys, size_t count, int32_t key, const less<int32_t> &){
+        return KeySearch::lower_bound(keys, count, key);
+    }
+};
+
+template <>
+struct NodeSearch<int64_t, less<int64_t> >{
+    static size_t lower_bound(const int64_t *keys, size_t count, int64_t key, const less<int64_t> &){
+        return KeySearch::lower_bound(keys, count, key);
+    }
+};
+
+#endif
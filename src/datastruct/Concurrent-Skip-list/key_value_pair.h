@@ -1,15 +1,32 @@
+#ifndef KEY_VALUE_PAIR_H
+#define KEY_VALUE_PAIR_H
+
 using namespace std;
 
 #include <string>
 
+/**
+    Stores a Key and value pair.
+    Both are stored inline, a fixed size value such as an integer or a POD struct needs no allocation.
+    The accessors return references and are defined here so that comparisons during a traversal are inlined.
+*/
+template <typename Key, typename Value>
 class KeyValuePair{
     private:
-        int key;
-        string value;
+        Key key;
+        Value value;
     public:
-        KeyValuePair();
-        KeyValuePair(int key, string value);
-        ~KeyValuePair();
-        int get_key();
-        string get_value();
-};
\ No newline at end of file
+        KeyValuePair() : key(), value(){
+        }
+        KeyValuePair(const Key &key, const Value &value) : key(key), value(value){
+        }
+
+        const Key &get_key() const{
+            return key;
+        }
+        const Value &get_value() const{
+            return value;
+        }
+};
+
+#endif
@@ -0,0 +1,40 @@
+/**
+    Seeding of the per thread level generators
+*/
+
+#include "level_generator.h"
+
+atomic<uint32_t> LevelGenerator::generation(1);
+
+static atomic<uint64_t> global_seed(0x853c49e6748fea9bULL);
+
+// Streams handed to the threads that did not select one
+static atomic<uint64_t> next_stream(1ULL << 32);
+
+void LevelGenerator::set_seed(uint64_t seed){
+    global_seed.store(seed);
+    generation.fetch_add(1);
+}
+
+void LevelGenerator::set_stream(uint64_t stream){
+    State &state = thread_state();
+    state.stream = stream;
+    state.has_stream = true;
+    reseed(state);
+}
+
+/**
+    Seeds the generator of the calling thread from the global seed and its stream, as pcg32_srandom does
+*/
+void LevelGenerator::reseed(State &state){
+    if(!state.has_stream){
+        state.stream = next_stream.fetch_add(1);
+        state.has_stream = true;
+    }
+    state.generation = generation.load();
+    state.increment = (state.stream << 1) | 1;
+    state.state = 0;
+    state.state = state.state * 6364136223846793005ULL + state.increment;
+    state.state += global_seed.load();
+    state.state = state.state * 6364136223846793005ULL + state.increment;
+}
@@ -0,0 +1,88 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include <atomic>
+#include <math.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+    Draws the top level of new nodes for a skip list, with P(level >= l) = probability^l up to max_level.
+    Every thread draws from its own PCG generator, so inserts share no state and take no lock.
+    The generators are seeded from a process wide seed and a stream number per thread, so a run with the same seed
+    and the same threads draws the same levels. Threads that do not pick a stream get one in the order they first draw.
+    When probability is 1/2^k the level is counted from the trailing zeros of one 64 bit draw, without a branch.
+*/
+class LevelGenerator{
+    public:
+        LevelGenerator() : max_level(0), shift(1), bound(1), log_probability(0){
+        }
+
+        LevelGenerator(int max_level, float probability) : max_level(max_level), shift(0), log_probability(log(probability)){
+            for (int k = 1; k <= 8; k++){
+                if(probability == ldexp(1.0f, -k)){
+                    shift = k;
+                }
+            }
+            int bits = shift * max_level < 63 ? shift * max_level : 63;
+            bound = (uint64_t)1 << bits;
+        }
+
+        int next() const{
+            uint64_t random = next_random();
+            if(shift > 0){
+                // The bound stops the count at max_level and keeps the argument of ctz non zero
+                return __builtin_ctzll(random | bound) / shift;
+            }
+            double uniform = (random >> 11) * (1.0 / 9007199254740992.0);
+            int level = (int)(log(1.0 - uniform) / log_probability);
+            return level < max_level ? level : max_level;
+        }
+
+        // Seeds every generator, threads reseed on their next draw
+        static void set_seed(uint64_t seed);
+
+        // Selects the stream of the calling thread, such as the index of a benchmark thread
+        static void set_stream(uint64_t stream);
+
+        static uint64_t next_random(){
+            State &state = thread_state();
+            if(state.generation != generation.load(memory_order_relaxed)){
+                reseed(state);
+            }
+            // PCG RXS M XS 64, every bit of the output is usable
+            uint64_t old = state.state;
+            state.state = old * 6364136223846793005ULL + state.increment;
+            uint64_t word = ((old >> ((old >> 59) + 5)) ^ old) * 12605985483714917081ULL;
+            return (word >> 43) ^ word;
+        }
+
+    private:
+        int max_level;
+
+        // k when probability is 1/2^k, else 0
+        int shift;
+        uint64_t bound;
+        double log_probability;
+
+        struct State{
+            uint64_t state;
+            uint64_t increment;
+            uint64_t stream;
+            bool has_stream;
+            uint32_t generation;
+        };
+
+        static State &thread_state(){
+            static thread_local State state = {0, 0, 0, false, 0};
+            return state;
+        }
+
+        static void reseed(State &state);
+
+        // Bumped by set_seed, starts at 1 so that every thread seeds on its first draw
+        static atomic<uint32_t> generation;
+};
+
+#endif
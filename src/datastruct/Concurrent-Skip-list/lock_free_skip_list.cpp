@@ -0,0 +1,344 @@
+/**
+    Implements a lock-free Concurrent Skip list with insert, delete, search and range operations.
+    Levels are linked with compare and swap on next references whose lowest bit marks the node as deleted.
+    No operation ever waits for another thread, a thread that finds a marked node unlinks it and moves on.
+*/
+
+#include <iostream>
+#include <math.h>
+#include <limits>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include "lock_free_skip_list.h"
+
+#define INT_MINI numeric_limits<int>::min()
+#define INT_MAXI numeric_limits<int>::max()
+
+/**
+    Node constructor. Both the inserter and the remover have to release the node before it is retired.
+*/
+LockFreeNode::LockFreeNode(int key, string value, int level) : next(level + 1){
+    key_value_pair = KeyValuePair<int, string>(key, value);
+    for (size_t i = 0; i < next.size(); i++){
+        next[i] = 0;
+    }
+    top_level = level;
+    pending = 2;
+}
+
+/**
+    Returns the key in the node
+*/
+int LockFreeNode::get_key(){
+    return key_value_pair.get_key();
+}
+
+/**
+    Returns the value in the node
+*/
+const string &LockFreeNode::get_value(){
+    return key_value_pair.get_value();
+}
+
+LockFreeNode::~LockFreeNode(){
+}
+
+/**
+    Constructor
+*/
+LockFreeSkipList::LockFreeSkipList(int max_elements, float prob){
+    max_level = (int) round(log(max_elements) / log(1/prob)) - 1;
+    if (max_level < 0) max_level = 0;
+    if (max_level > MAX_LEVEL) max_level = MAX_LEVEL;
+    levels = LevelGenerator(max_level, prob);
+
+    head = new LockFreeNode(INT_MINI, "", max_level);
+    tail = new LockFreeNode(INT_MAXI, "", max_level);
+
+    for (int i = 0; i <= max_level; i++) {
+        head->next[i] = make_reference(tail, false);
+    }
+}
+
+/**
+    Draws the top level of a new node, each level is reached with the probability given to the constructor.
+*/
+int LockFreeSkipList::get_random_level() {
+    return levels.next();
+}
+
+/**
+    Finds the predecessors and successors at each level of where a given key exists or might exist.
+    Nodes marked as deleted on the way are unlinked, if that fails because of a concurrent change
+    the search starts again from the head.
+    Returns true if an unmarked node with the key is present.
+*/
+bool LockFreeSkipList::find(int key, LockFreeNode **predecessors, LockFreeNode **successors){
+retry:
+    LockFreeNode *pred = head;
+    LockFreeNode *curr = NULL;
+
+    for (int level = max_level; level >= 0; level--){
+        curr = get_node(pred->next[level].load());
+
+        while (true){
+            uintptr_t succ = curr->next[level].load();
+
+            // curr is deleted at this level, unlink it from pred
+            while (is_marked(succ)){
+                uintptr_t expected = make_reference(curr, false);
+                if (!pred->next[level].compare_exchange_strong(expected, make_reference(get_node(succ), false))){
+                    goto retry;
+                }
+                curr = get_node(succ);
+                succ = curr->next[level].load();
+            }
+
+            if (key > curr->get_key()){
+                pred = curr;
+                curr = get_node(succ);
+            }else{
+                break;
+            }
+        }
+
+        predecessors[level] = pred;
+        successors[level] = curr;
+    }
+
+    return curr->get_key() == key;
+}
+
+/**
+    Hands the node over to the reclaimer once both its inserter and its remover are done with it
+*/
+void LockFreeSkipList::release(LockFreeNode *node){
+    if (node->pending.fetch_sub(1) == 1){
+        EpochManager::retire(node);
+    }
+}
+
+/**
+    Inserts into the Skip list. The node is linked at level 0 with a single compare and swap,
+    which makes it part of the list, and then at the upper levels one at a time.
+    Return if already exists.
+*/
+bool LockFreeSkipList::add(int key, string value){
+    EpochGuard guard;
+
+    int top_level = get_random_level();
+    LockFreeNode *preds[MAX_LEVEL + 1];
+    LockFreeNode *succs[MAX_LEVEL + 1];
+
+    while (true){
+        if (find(key, preds, succs)){
+            return false;
+        }
+
+        LockFreeNode *new_node = new LockFreeNode(key, value, top_level);
+        for (int level = 0; level <= top_level; level++){
+            new_node->next[level] = make_reference(succs[level], false);
+        }
+
+        // Link at the bottom level. If it fails the predecessor changed, so try again
+        uintptr_t expected = make_reference(succs[0], false);
+        if (!preds[0]->next[0].compare_exchange_strong(expected, make_reference(new_node, false))){
+            delete new_node;
+            continue;
+        }
+
+        // Link the upper levels, stop as soon as a remover has marked the node
+        for (int level = 1; level <= top_level; level++){
+            while (true){
+                uintptr_t next = new_node->next[level].load();
+                if (is_marked(next)){
+                    goto linked;
+                }
+                if (get_node(next) != succs[level] &&
+                        !new_node->next[level].compare_exchange_strong(next, make_reference(succs[level], false))){
+                    continue;
+                }
+
+                expected = make_reference(succs[level], false);
+                if (preds[level]->next[level].compare_exchange_strong(expected, make_reference(new_node, false))){
+                    break;
+                }
+
+                // Predecessor changed, look up the level again. Stop if the node was removed meanwhile
+                find(key, preds, succs);
+                if (succs[0] != new_node){
+                    goto linked;
+                }
+            }
+        }
+
+    linked:
+        // A remover may have run its cleanup before the last level was linked, unlink the node again
+        if (is_marked(new_node->next[0].load())){
+            find(key, preds, succs);
+        }
+        release(new_node);
+        return true;
+    }
+}
+
+/**
+    Traverses the skip list once without unlinking or waiting for anything.
+    Returns the unmarked node with the key, else NULL. Must be called inside an epoch.
+*/
+LockFreeNode *LockFreeSkipList::lookup(int key){
+    LockFreeNode *pred = head;
+    LockFreeNode *curr = NULL;
+
+    for (int level = max_level; level >= 0; level--){
+        curr = get_node(pred->next[level].load());
+        while (true){
+            uintptr_t succ = curr->next[level].load();
+            while (is_marked(succ)){
+                curr = get_node(succ);
+                succ = curr->next[level].load();
+            }
+            if (key > curr->get_key()){
+                pred = curr;
+                curr = get_node(succ);
+            }else{
+                break;
+            }
+        }
+    }
+
+    return curr->get_key() == key ? curr : NULL;
+}
+
+/**
+    Performs search to find if a node exists.
+    Return value if the key found, else return empty
+*/
+string LockFreeSkipList::search(int key){
+    EpochGuard guard;
+
+    LockFreeNode *node = lookup(key);
+    return node != NULL ? node->get_value() : "";
+}
+
+/**
+    Return true if the key found
+*/
+bool LockFreeSkipList::contains(int key){
+    EpochGuard guard;
+    return lookup(key) != NULL;
+}
+
+/**
+    Deletes from the Skip list. The node is marked at every level from the top down,
+    the thread that marks the bottom level owns the delete and unlinks the node.
+    Return if key doesn’t exist in the list.
+*/
+bool LockFreeSkipList::remove(int key){
+    EpochGuard guard;
+
+    LockFreeNode *preds[MAX_LEVEL + 1];
+    LockFreeNode *succs[MAX_LEVEL + 1];
+
+    if (!find(key, preds, succs)){
+        return false;
+    }
+
+    LockFreeNode *victim = succs[0];
+
+    for (int level = victim->top_level; level >= 1; level--){
+        uintptr_t next = victim->next[level].load();
+        while (!is_marked(next)){
+            victim->next[level].compare_exchange_weak(next, next | 1);
+        }
+    }
+
+    uintptr_t next = victim->next[0].load();
+    while (true){
+        // Another thread deleted the node first
+        if (is_marked(next)){
+            return false;
+        }
+        if (victim->next[0].compare_exchange_weak(next, next | 1)){
+            find(key, preds, succs);
+            release(victim);
+            return true;
+        }
+    }
+}
+
+/**
+    Traverses the skip list from the top level down to the last node before key at every level.
+    Returns the node following it at level 0, the first node whose key is not before key.
+    Must be called inside an epoch.
+*/
+LockFreeNode *LockFreeSkipList::lower_bound(int key){
+    LockFreeNode *pred = head;
+    LockFreeNode *curr = NULL;
+    for (int level = max_level; level >= 0; level--){
+        curr = get_node(pred->next[level].load());
+        while (key > curr->get_key()){
+            pred = curr;
+            curr = get_node(curr->next[level].load());
+        }
+    }
+    // Reloading pred->next[0] could return a key inserted between pred and key meanwhile
+    return curr;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key in a map.
+    Use scan to read a range without copying it.
+*/
+map<int, string> LockFreeSkipList::range(int start_key, int end_key){
+    map<int, string> range_output;
+    scan(start_key, end_key, [&range_output](int key, const string &value){
+        range_output.insert(range_output.end(), make_pair(key, value));
+    });
+    return range_output;
+}
+
+/**
+    Walks level 0 from the head to the tail, one node after the other.
+    Returns the number of unmarked nodes.
+*/
+size_t LockFreeSkipList::size(){
+    EpochGuard guard;
+
+    size_t count = 0;
+    LockFreeNode *curr = get_node(head->next[0].load());
+    while (curr != tail){
+        uintptr_t next = curr->next[0].load();
+        if (!is_marked(next)){
+            count++;
+        }
+        curr = get_node(next);
+    }
+    return count;
+}
+
+/**
+    Display the skip list in readable format
+*/
+void LockFreeSkipList::display(){
+    for (int i = 0; i <= max_level; i++) {
+        LockFreeNode *temp = head;
+        if (get_node(temp->next[i].load()) == tail){
+            break;
+        }
+        printf("Level %d  ", i);
+        while (temp != NULL){
+            printf("%d -> ", temp->get_key());
+            temp = (temp == tail) ? NULL : get_node(temp->next[i].load());
+        }
+        cout<<endl;
+    }
+    printf("---------- Display done! ----------\n\n");
+}
+
+LockFreeSkipList::LockFreeSkipList(){
+}
+
+LockFreeSkipList::~LockFreeSkipList(){
+}
@@ -0,0 +1,114 @@
+#ifndef LOCK_FREE_SKIP_LIST_H
+#define LOCK_FREE_SKIP_LIST_H
+
+#include <map>
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <stdint.h>
+#include "key_value_pair.h"
+#include "epoch.h"
+#include "level_generator.h"
+
+class LockFreeNode{
+    public:
+        // Stores the key and value for the Node
+        KeyValuePair<int, string> key_value_pair;
+
+        // Reference of the next node at every level until the top level.
+        // The lowest bit of a reference marks this node as deleted at that level.
+        vector<atomic<uintptr_t>> next;
+
+        // The Maximum level until which the node is available
+        int top_level;
+
+        // Number of threads, the inserter and the remover, that still link or unlink the node.
+        // The last one to finish retires the node.
+        atomic<int> pending;
+
+        LockFreeNode(int key, string value, int level);
+        ~LockFreeNode();
+        int get_key();
+        const string &get_value();
+};
+
+/**
+    Helpers to pack and unpack a node reference and its deleted mark
+*/
+static inline LockFreeNode *get_node(uintptr_t reference){
+    return reinterpret_cast<LockFreeNode *>(reference & ~(uintptr_t)1);
+}
+
+static inline bool is_marked(uintptr_t reference){
+    return reference & 1;
+}
+
+static inline uintptr_t make_reference(LockFreeNode *node, bool marked){
+    return reinterpret_cast<uintptr_t>(node) | (marked ? 1 : 0);
+}
+
+class LockFreeSkipList{
+    private:
+        // Head and Tail of the Skiplist
+        LockFreeNode *head;
+        LockFreeNode *tail;
+
+        // Highest level a node can have in this list
+        int max_level;
+
+        // Draws the levels of new nodes with the probability of the list
+        LevelGenerator levels;
+
+        void release(LockFreeNode *node);
+        LockFreeNode *lookup(int key);
+        LockFreeNode *lower_bound(int key);
+    public:
+        // Upper bound of max_level, sizes the predecessor and successor arrays
+        static const int MAX_LEVEL = 32;
+
+        LockFreeSkipList();
+        LockFreeSkipList(int max_elements, float probability);
+        ~LockFreeSkipList();
+        int get_random_level();
+
+        // Supported operations
+        bool find(int key, LockFreeNode **predecessors, LockFreeNode **successors);
+        bool add(int key, string value);
+        string search(int key);
+        bool contains(int key);
+        bool remove(int key);
+        map<int, string> range(int start_key, int end_key);
+        template <typename Function>
+        size_t scan(int start_key, int end_key, Function visitor, size_t limit = numeric_limits<size_t>::max());
+        size_t size();
+        void display();
+};
+
+/**
+    Walks level 0 from the first key not before start_key and passes every key and value up to end_key
+    to visitor, without copying them. Marked nodes are skipped. Stops after limit pairs.
+    The references are only valid inside visitor.
+    Returns the number of pairs visited.
+*/
+template <typename Function>
+size_t LockFreeSkipList::scan(int start_key, int end_key, Function visitor, size_t limit){
+    if(start_key > end_key){
+        return 0;
+    }
+
+    EpochGuard guard;
+
+    size_t count = 0;
+    LockFreeNode *curr = lower_bound(start_key);
+    while (count < limit && curr != tail && end_key >= curr->get_key()){
+        uintptr_t next = curr->next[0].load();
+        if (!is_marked(next)){
+            visitor(curr->get_key(), curr->get_value());
+            count++;
+        }
+        curr = get_node(next);
+    }
+    return count;
+}
+
+#endif
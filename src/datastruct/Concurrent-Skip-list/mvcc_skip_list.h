@@ -0,0 +1,428 @@
+#ifndef MVCC_SKIP_LIST_H
+#define MVCC_SKIP_LIST_H
+
+/**
+    Multi version Concurrent Skip list, following the version chains of JellyFish (doc/papers).
+    Every key in the index points to a chain of versions, newest first, stamped from a global clock.
+    A snapshot is a timestamp, reads through it see the newest version of every key stamped at or before it,
+    so a range read with a snapshot is consistent while writers keep updating.
+*/
+
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <stdint.h>
+#include "skip_list.h"
+#include "spin_wait.h"
+
+template <typename Key, typename Value, typename Compare = less<Key> >
+class MvccSkipList{
+    private:
+        // Timestamp of a version that is linked into its chain but not stamped yet
+        static const uint64_t PENDING = ~(uint64_t)0;
+
+        // Number of updates to a chain between two attempts to trim its old versions
+        static const uint32_t TRIM_INTERVAL = 8;
+
+        struct Version{
+            Value value;
+
+            // Set if the version records a remove
+            bool deleted;
+
+            // Clock value the version was committed at, PENDING until then
+            atomic<uint64_t> timestamp;
+
+            // Next older version of the key
+            atomic<Version *> older;
+
+            Version(const Value &value, bool deleted, Version *older) : value(value), deleted(deleted),
+                    timestamp(PENDING), older(older){
+            }
+        };
+
+        struct VersionChain{
+            atomic<Version *> newest;
+
+            // Updates since the chain was created, decides when to trim
+            atomic<uint32_t> updates;
+
+            // Held by the thread trimming the chain
+            atomic<bool> trimming;
+
+            VersionChain() : newest(NULL), updates(0), trimming(false){
+            }
+        };
+
+        typedef BasicSkipList<Key, VersionChain *, Compare> index_type;
+
+        // Kinds of update, an add and a remove only commit if the key is absent or live respectively
+        enum Update { ADD, PUT, REMOVE };
+
+        // Keys and their chains. Keys are never unlinked from the index, a remove adds a deleted version
+        index_type index;
+
+        // Global clock, the timestamp of the last commit
+        atomic<uint64_t> clock;
+
+        // Timestamps of the open snapshots
+        mutex snapshots_lock;
+        multiset<uint64_t> snapshots;
+
+        VersionChain *get_chain(const Key &key);
+        VersionChain *get_or_add_chain(const Key &key);
+        bool install(const Key &key, const Value &value, Update update);
+        void trim(VersionChain *chain);
+
+        /**
+            Waits until a version that was just linked is stamped and returns its timestamp.
+            The writer may be preempted in between, so the wait backs off and then yields.
+        */
+        static uint64_t committed_timestamp(Version *version){
+            uint64_t timestamp;
+            Backoff backoff;
+            while((timestamp = version->timestamp.load()) == PENDING){
+                backoff.wait();
+            }
+            return timestamp;
+        }
+
+        /**
+            Returns the newest version of the chain stamped at or before timestamp, else NULL.
+            Must be called inside an epoch.
+        */
+        static Version *visible(VersionChain *chain, uint64_t timestamp){
+            Version *version = chain->newest.load();
+            while(version != NULL && committed_timestamp(version) > timestamp){
+                version = version->older.load();
+            }
+            return version;
+        }
+
+        /**
+            Returns the newest version of the chain once it is stamped, else NULL.
+            Must be called inside an epoch.
+        */
+        static Version *latest(VersionChain *chain){
+            Version *version = chain->newest.load();
+            if(version != NULL){
+                committed_timestamp(version);
+            }
+            return version;
+        }
+
+        static void delete_versions(void *version){
+            Version *curr = static_cast<Version *>(version);
+            while(curr != NULL){
+                Version *older = curr->older.load();
+                delete curr;
+                curr = older;
+            }
+        }
+
+    public:
+        /**
+            A consistent view of the list at the time it was taken.
+            Versions it can see are kept until it is destroyed, so keep it only as long as the reads need it.
+        */
+        class Snapshot{
+            public:
+                Snapshot(MvccSkipList &list) : list(list){
+                    lock_guard<mutex> guard(list.snapshots_lock);
+                    timestamp = list.clock.load();
+                    entry = list.snapshots.insert(timestamp);
+                }
+                ~Snapshot(){
+                    lock_guard<mutex> guard(list.snapshots_lock);
+                    list.snapshots.erase(entry);
+                }
+                uint64_t get_timestamp() const{
+                    return timestamp;
+                }
+            private:
+                MvccSkipList &list;
+                uint64_t timestamp;
+                typename multiset<uint64_t>::iterator entry;
+
+                Snapshot(const Snapshot &);
+                Snapshot &operator=(const Snapshot &);
+        };
+
+        MvccSkipList(int max_elements, float probability, const Compare &compare = Compare());
+        ~MvccSkipList();
+
+        // Updates, each one commits a new version
+        bool add(const Key &key, const Value &value);
+        bool put(const Key &key, const Value &value);
+        bool remove(const Key &key);
+
+        // Reads of the latest committed state
+        Value search(const Key &key);
+        bool contains(const Key &key);
+        map<Key, Value, Compare> range(const Key &start_key, const Key &end_key);
+
+        // Reads of the state seen by a snapshot
+        bool search(const Key &key, const Snapshot &snapshot, Value &value);
+        map<Key, Value, Compare> range(const Key &start_key, const Key &end_key, const Snapshot &snapshot);
+        template <typename Function>
+        size_t scan(const Key &start_key, const Key &end_key, const Snapshot &snapshot, Function visitor,
+                size_t limit = numeric_limits<size_t>::max());
+
+        uint64_t get_clock();
+};
+
+/**
+    Constructor
+*/
+template <typename Key, typename Value, typename Compare>
+MvccSkipList<Key, Value, Compare>::MvccSkipList(int max_elements, float probability, const Compare &compare)
+        : index(max_elements, probability, compare), clock(0){
+}
+
+/**
+    Destructor. Frees every chain and the versions still linked in it, trimmed versions belong to the epoch reclaimer.
+*/
+template <typename Key, typename Value, typename Compare>
+MvccSkipList<Key, Value, Compare>::~MvccSkipList(){
+    index.scan_all([](const Key &, VersionChain *chain){
+        delete_versions(chain->newest.load());
+        delete chain;
+    });
+}
+
+/**
+    Returns the chain of the key, else NULL
+*/
+template <typename Key, typename Value, typename Compare>
+typename MvccSkipList<Key, Value, Compare>::VersionChain *MvccSkipList<Key, Value, Compare>::get_chain(const Key &key){
+    VersionChain *chain = NULL;
+    index.search(key, [&chain](VersionChain *found){ chain = found; });
+    return chain;
+}
+
+/**
+    Returns the chain of the key, adding an empty one to the index if the key was never seen
+*/
+template <typename Key, typename Value, typename Compare>
+typename MvccSkipList<Key, Value, Compare>::VersionChain *MvccSkipList<Key, Value, Compare>::get_or_add_chain(const Key &key){
+    VersionChain *chain = get_chain(key);
+    if(chain != NULL){
+        return chain;
+    }
+
+    chain = new VersionChain();
+    if(index.add(key, chain)){
+        return chain;
+    }
+
+    // Another thread added the key first
+    delete chain;
+    return get_chain(key);
+}
+
+/**
+    Links a new version at the head of the key's chain and stamps it with the next clock value.
+    An add of a live key and a remove of a key without a live version install nothing.
+    Returns true if the update was committed and, for a put, if the key had no live version before.
+*/
+template <typename Key, typename Value, typename Compare>
+bool MvccSkipList<Key, Value, Compare>::install(const Key &key, const Value &value, Update update){
+    EpochGuard guard;
+
+    VersionChain *chain = update == REMOVE ? get_chain(key) : get_or_add_chain(key);
+    if(chain == NULL){
+        return false;
+    }
+
+    Version *version = NULL;
+    bool was_live;
+    while(true){
+        // Timestamps grow along the chain, so the previous version is stamped before this one is linked
+        Version *newest = latest(chain);
+        was_live = newest != NULL && !newest->deleted;
+
+        if((update == ADD && was_live) || (update == REMOVE && !was_live)){
+            delete version;
+            return false;
+        }
+
+        if(version == NULL){
+            version = new Version(value, update == REMOVE, newest);
+        }else{
+            version->older.store(newest);
+        }
+        if(chain->newest.compare_exchange_strong(newest, version)){
+            break;
+        }
+    }
+
+    // Linked before stamped: a snapshot taken after this stamp finds the version in the chain
+    version->timestamp.store(clock.fetch_add(1) + 1);
+
+    if(chain->updates.fetch_add(1) % TRIM_INTERVAL == TRIM_INTERVAL - 1){
+        trim(chain);
+    }
+    return update == PUT ? !was_live : true;
+}
+
+/**
+    Unlinks the versions no open or future snapshot can see and retires them.
+    The newest version stamped at or before the oldest snapshot, or the clock if there is none, is the
+    oldest one that is still needed.
+*/
+template <typename Key, typename Value, typename Compare>
+void MvccSkipList<Key, Value, Compare>::trim(VersionChain *chain){
+    bool expected = false;
+    if(!chain->trimming.compare_exchange_strong(expected, true)){
+        return;
+    }
+
+    uint64_t horizon;
+    {
+        lock_guard<mutex> guard(snapshots_lock);
+        horizon = snapshots.empty() ? clock.load() : *snapshots.begin();
+    }
+
+    Version *keep = visible(chain, horizon);
+    if(keep != NULL){
+        Version *garbage = keep->older.exchange(NULL);
+        if(garbage != NULL){
+            EpochManager::retire(garbage, delete_versions);
+        }
+    }
+
+    chain->trimming.store(false);
+}
+
+/**
+    Inserts the key if it has no live version.
+    Return if already exists.
+*/
+template <typename Key, typename Value, typename Compare>
+bool MvccSkipList<Key, Value, Compare>::add(const Key &key, const Value &value){
+    return install(key, value, ADD);
+}
+
+/**
+    Inserts the key or replaces its value.
+    Returns true if the key had no live version before.
+*/
+template <typename Key, typename Value, typename Compare>
+bool MvccSkipList<Key, Value, Compare>::put(const Key &key, const Value &value){
+    return install(key, value, PUT);
+}
+
+/**
+    Commits a deleted version of the key. Older snapshots still see the previous value.
+    Return if key doesn’t exist in the list.
+*/
+template <typename Key, typename Value, typename Compare>
+bool MvccSkipList<Key, Value, Compare>::remove(const Key &key){
+    return install(key, Value(), REMOVE);
+}
+
+/**
+    Returns the value of the key seen by the snapshot through value.
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+bool MvccSkipList<Key, Value, Compare>::search(const Key &key, const Snapshot &snapshot, Value &value){
+    EpochGuard guard;
+
+    VersionChain *chain = get_chain(key);
+    if(chain == NULL){
+        return false;
+    }
+    Version *version = visible(chain, snapshot.get_timestamp());
+    if(version == NULL || version->deleted){
+        return false;
+    }
+    value = version->value;
+    return true;
+}
+
+/**
+    Performs search on the latest committed state.
+    Return value if the key found, else return a default constructed value
+*/
+template <typename Key, typename Value, typename Compare>
+Value MvccSkipList<Key, Value, Compare>::search(const Key &key){
+    EpochGuard guard;
+
+    VersionChain *chain = get_chain(key);
+    if(chain == NULL){
+        return Value();
+    }
+    Version *version = latest(chain);
+    return (version == NULL || version->deleted) ? Value() : version->value;
+}
+
+/**
+    Return true if the key has a live version
+*/
+template <typename Key, typename Value, typename Compare>
+bool MvccSkipList<Key, Value, Compare>::contains(const Key &key){
+    EpochGuard guard;
+
+    VersionChain *chain = get_chain(key);
+    if(chain == NULL){
+        return false;
+    }
+    Version *version = latest(chain);
+    return version != NULL && !version->deleted;
+}
+
+/**
+    Passes every key between start_key and end_key with a live version in the snapshot to visitor,
+    along with a reference to that version's value. Stops after limit pairs.
+    The references are only valid inside visitor.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+size_t MvccSkipList<Key, Value, Compare>::scan(const Key &start_key, const Key &end_key, const Snapshot &snapshot,
+        Function visitor, size_t limit){
+    size_t count = 0;
+    typename index_type::Scan keys(index, start_key, end_key);
+    for (typename index_type::const_iterator it = keys.begin(); count < limit && it != keys.end(); ++it){
+        Version *version = visible(it.value(), snapshot.get_timestamp());
+        if(version != NULL && !version->deleted){
+            visitor(it.key(), version->value);
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key seen by the snapshot
+*/
+template <typename Key, typename Value, typename Compare>
+map<Key, Value, Compare> MvccSkipList<Key, Value, Compare>::range(const Key &start_key, const Key &end_key,
+        const Snapshot &snapshot){
+    map<Key, Value, Compare> range_output;
+    scan(start_key, end_key, snapshot, [&range_output](const Key &key, const Value &value){
+        range_output.insert(range_output.end(), make_pair(key, value));
+    });
+    return range_output;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key in a snapshot taken now
+*/
+template <typename Key, typename Value, typename Compare>
+map<Key, Value, Compare> MvccSkipList<Key, Value, Compare>::range(const Key &start_key, const Key &end_key){
+    Snapshot snapshot(*this);
+    return range(start_key, end_key, snapshot);
+}
+
+/**
+    Returns the timestamp of the last commit
+*/
+template <typename Key, typename Value, typename Compare>
+uint64_t MvccSkipList<Key, Value, Compare>::get_clock(){
+    return clock.load();
+}
+
+#endif
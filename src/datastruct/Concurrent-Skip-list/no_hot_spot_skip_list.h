@@ -0,0 +1,587 @@
+#ifndef NO_HOT_SPOT_SKIP_LIST_H
+#define NO_HOT_SPOT_SKIP_LIST_H
+
+/**
+    Implements a skip list whose operations only change level 0, with the upper levels maintained in the background
+*/
+
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include <stdio.h>
+#include "key_value_pair.h"
+#include "epoch.h"
+#include "node_allocator.h"
+#include "numa_support.h"
+
+/**
+    Skip list ordered by Compare on Key in the style of the No Hot Spot skip list (doc/papers).
+    Level 0 is a lock-free sorted list: an insert links its node with one compare and swap, a remove marks
+    the node's next reference with one compare and swap, and traversals unlink the marked nodes they pass.
+    The upper levels are not linked by the operations. A maintenance thread owned by the list walks level 0,
+    rebuilds an index holding the keys of every INDEX_STRIDE-th node in a sorted array and publishes it.
+    A search starts from the last indexed node before its key, so it stays logarithmic between rebuilds
+    as long as few keys were inserted since the last one.
+    Unlinked nodes are retired once an index that cannot reference them is published.
+    In the NUMA aware mode the index is copied to every NUMA node and a search reads the copy of its own node.
+*/
+template <typename Key, typename Value, typename Compare = less<Key> >
+class NoHotSpotSkipList{
+    public:
+        class Node{
+            public:
+                // Stores the key and value for the Node
+                KeyValuePair<Key, Value> key_value_pair;
+
+                // Reference of the next node, the lowest bit marks this node as deleted
+                atomic<uintptr_t> next;
+
+                // Next node in the stack of unlinked nodes waiting for the next rebuild
+                Node *next_unlinked;
+
+                Node(const Key &key, const Value &value) : key_value_pair(key, value), next(0), next_unlinked(NULL){
+                }
+
+                // Nodes come from the slabs of the node allocator, on the NUMA node of the inserting thread
+                static void *operator new(size_t size){
+                    return NodeAllocator::allocate(size);
+                }
+                static void operator delete(void *memory, size_t size){
+                    NodeAllocator::deallocate(memory, size);
+                }
+
+                const Key &get_key() const{
+                    return key_value_pair.get_key();
+                }
+                const Value &get_value() const{
+                    return key_value_pair.get_value();
+                }
+        };
+        typedef Node node_type;
+
+        // One node of level 0 out of INDEX_STRIDE is indexed
+        static const size_t INDEX_STRIDE = 4;
+
+        // Pause between two rebuilds in microseconds
+        static const int REBUILD_PAUSE_US = 200;
+
+    private:
+        /**
+            Keys of the indexed nodes in order and the nodes, as seen by one walk of level 0, stored on one NUMA node.
+            Never changed once published.
+        */
+        struct Index{
+            vector<Key, NumaAllocator<Key> > keys;
+            vector<node_type *, NumaAllocator<node_type *> > nodes;
+
+            explicit Index(int numa_node) : keys(NumaAllocator<Key>(numa_node)), nodes(NumaAllocator<node_type *>(numa_node)){
+            }
+        };
+
+        // Head and Tail of level 0
+        node_type *head;
+        node_type *tail;
+
+        // Orders the keys
+        Compare compare;
+
+        // Index in use on every NUMA node, NULL until the first rebuild.
+        // There is one replica per node in the NUMA aware mode and a single one otherwise.
+        atomic<Index *> *index;
+        int replicas;
+
+        // Stack of nodes unlinked by operations, retired by the rebuild after the next one
+        atomic<node_type *> unlinked;
+
+        // Set by an update once the index was last rebuilt, so an unchanged list is not walked again.
+        // Checked before it is written, so the cache line stays shared between rebuilds.
+        atomic<bool> changed;
+
+        atomic<bool> stopping;
+        thread maintainer;
+
+        node_type *start(const Key &key);
+        void find(const Key &key, node_type *&pred, node_type *&curr);
+        node_type *lookup(const Key &key);
+        void push_unlinked(node_type *node);
+        void rebuild();
+        void maintain();
+
+        /**
+            Returns true if the node comes before key in the list. The tail comes after every key.
+        */
+        bool before(node_type *node, const Key &key){
+            return node != tail && compare(node->get_key(), key);
+        }
+
+        /**
+            Returns true if the node holds key
+        */
+        bool holds(node_type *node, const Key &key){
+            return node != tail && !compare(key, node->get_key());
+        }
+
+        /**
+            Returns the index replica of the node the calling thread runs on
+        */
+        Index *local_index(){
+            int replica = replicas == 1 ? 0 : NumaSupport::current_node() % replicas;
+            return index[replica].load(memory_order_acquire);
+        }
+
+        void mark_changed(){
+            if(!changed.load(memory_order_relaxed)){
+                changed.store(true, memory_order_relaxed);
+            }
+        }
+
+        /**
+            Helpers to pack and unpack a node reference and its deleted mark
+        */
+        static node_type *get_node(uintptr_t reference){
+            return reinterpret_cast<node_type *>(reference & ~(uintptr_t)1);
+        }
+        static bool is_marked(uintptr_t reference){
+            return reference & 1;
+        }
+        static uintptr_t make_reference(node_type *node, bool marked){
+            return reinterpret_cast<uintptr_t>(node) | (marked ? 1 : 0);
+        }
+
+        NoHotSpotSkipList(const NoHotSpotSkipList &);
+        NoHotSpotSkipList &operator=(const NoHotSpotSkipList &);
+
+    public:
+        NoHotSpotSkipList(int max_elements, float probability, const Compare &compare = Compare());
+        ~NoHotSpotSkipList();
+
+        // Supported operations
+        bool add(const Key &key, const Value &value);
+        Value search(const Key &key);
+        bool contains(const Key &key);
+        template <typename Function>
+        bool search(const Key &key, Function on_found);
+        bool remove(const Key &key);
+        map<Key, Value, Compare> range(const Key &start_key, const Key &end_key);
+        template <typename Function>
+        size_t scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit = numeric_limits<size_t>::max());
+        size_t size();
+        void display();
+};
+
+template <typename Key, typename Value, typename Compare>
+const size_t NoHotSpotSkipList<Key, Value, Compare>::INDEX_STRIDE;
+
+template <typename Key, typename Value, typename Compare>
+const int NoHotSpotSkipList<Key, Value, Compare>::REBUILD_PAUSE_US;
+
+/**
+    Constructor. Starts the maintenance thread, which runs until the list is destroyed.
+    There are no levels to size, max_elements and probability are accepted for the same interface as SkipList.
+*/
+template <typename Key, typename Value, typename Compare>
+NoHotSpotSkipList<Key, Value, Compare>::NoHotSpotSkipList(int, float, const Compare &compare)
+        : compare(compare), unlinked(NULL), changed(false), stopping(false){
+    replicas = NumaSupport::enabled() ? NumaSupport::num_nodes() : 1;
+    index = new atomic<Index *>[replicas];
+    for (int i = 0; i < replicas; i++){
+        index[i].store(NULL);
+    }
+
+    head = new node_type(Key(), Value());
+    tail = new node_type(Key(), Value());
+    head->next = make_reference(tail, false);
+
+    maintainer = thread(&NoHotSpotSkipList::maintain, this);
+}
+
+/**
+    Stops the maintenance thread and frees the nodes. No operation may run on the list any more.
+    The nodes and index already retired are freed by the epoch manager.
+*/
+template <typename Key, typename Value, typename Compare>
+NoHotSpotSkipList<Key, Value, Compare>::~NoHotSpotSkipList(){
+    stopping = true;
+    maintainer.join();
+
+    for (int i = 0; i < replicas; i++){
+        delete index[i].load();
+    }
+    delete[] index;
+    for (node_type *node = unlinked.load(); node != NULL; ){
+        node_type *next = node->next_unlinked;
+        delete node;
+        node = next;
+    }
+    for (node_type *node = head; node != tail; ){
+        node_type *next = get_node(node->next.load());
+        delete node;
+        node = next;
+    }
+    delete tail;
+}
+
+/**
+    Returns the node a search for key starts from, the last indexed node before key that is not deleted.
+    A deleted node may already be unlinked and would miss the nodes inserted after it, it is skipped.
+    Must be called inside an epoch.
+*/
+template <typename Key, typename Value, typename Compare>
+typename NoHotSpotSkipList<Key, Value, Compare>::node_type *NoHotSpotSkipList<Key, Value, Compare>::start(const Key &key){
+    Index *current = local_index();
+    if(current == NULL){
+        return head;
+    }
+
+    size_t i = lower_bound(current->keys.begin(), current->keys.end(), key, compare) - current->keys.begin();
+    while(i > 0){
+        node_type *node = current->nodes[i - 1];
+        if(!is_marked(node->next.load())){
+            return node;
+        }
+        i--;
+    }
+    return head;
+}
+
+/**
+    Finds the last node before key and the node after it on level 0, starting from the index.
+    Unlinks the deleted nodes on the way and starts over if another thread changed the list under it.
+    Must be called inside an epoch.
+*/
+template <typename Key, typename Value, typename Compare>
+void NoHotSpotSkipList<Key, Value, Compare>::find(const Key &key, node_type *&pred, node_type *&curr){
+    retry:
+    while(true){
+        pred = start(key);
+        curr = get_node(pred->next.load());
+
+        while(true){
+            if(curr == tail){
+                return;
+            }
+            uintptr_t succ = curr->next.load();
+            while(is_marked(succ)){
+                uintptr_t expected = make_reference(curr, false);
+                if(!pred->next.compare_exchange_strong(expected, make_reference(get_node(succ), false))){
+                    goto retry;
+                }
+                push_unlinked(curr);
+                curr = get_node(succ);
+                if(curr == tail){
+                    return;
+                }
+                succ = curr->next.load();
+            }
+
+            if(!before(curr, key)){
+                return;
+            }
+            pred = curr;
+            curr = get_node(succ);
+        }
+    }
+}
+
+/**
+    Hands an unlinked node over to the maintenance thread
+*/
+template <typename Key, typename Value, typename Compare>
+void NoHotSpotSkipList<Key, Value, Compare>::push_unlinked(node_type *node){
+    node_type *top = unlinked.load();
+    do{
+        node->next_unlinked = top;
+    }while(!unlinked.compare_exchange_weak(top, node));
+}
+
+/**
+    Inserts a node on level 0 with one compare and swap.
+    Return if already exists.
+*/
+template <typename Key, typename Value, typename Compare>
+bool NoHotSpotSkipList<Key, Value, Compare>::add(const Key &key, const Value &value){
+    EpochGuard guard;
+
+    node_type *new_node = NULL;
+    while(true){
+        node_type *pred;
+        node_type *curr;
+        find(key, pred, curr);
+
+        if(holds(curr, key)){
+            // The new node was never linked, nobody else can reference it
+            delete new_node;
+            return false;
+        }
+
+        if(new_node == NULL){
+            new_node = new node_type(key, value);
+        }
+        new_node->next.store(make_reference(curr, false), memory_order_relaxed);
+
+        uintptr_t expected = make_reference(curr, false);
+        if(pred->next.compare_exchange_strong(expected, make_reference(new_node, false))){
+            mark_changed();
+            return true;
+        }
+    }
+}
+
+/**
+    Deletes a key by marking the next reference of its node with one compare and swap.
+    The node is unlinked by the next traversal that passes it.
+    Return if key doesn’t exist in the list.
+*/
+template <typename Key, typename Value, typename Compare>
+bool NoHotSpotSkipList<Key, Value, Compare>::remove(const Key &key){
+    EpochGuard guard;
+
+    while(true){
+        node_type *pred;
+        node_type *curr;
+        find(key, pred, curr);
+
+        if(!holds(curr, key)){
+            return false;
+        }
+
+        uintptr_t succ = curr->next.load();
+        if(is_marked(succ)){
+            return false;
+        }
+        if(curr->next.compare_exchange_strong(succ, succ | 1)){
+            mark_changed();
+            return true;
+        }
+    }
+}
+
+/**
+    Walks level 0 from the index without changing anything.
+    Returns the node if it holds key and is not deleted, else NULL. Must be called inside an epoch.
+*/
+template <typename Key, typename Value, typename Compare>
+typename NoHotSpotSkipList<Key, Value, Compare>::node_type *NoHotSpotSkipList<Key, Value, Compare>::lookup(const Key &key){
+    node_type *curr = get_node(start(key)->next.load());
+    while(before(curr, key)){
+        curr = get_node(curr->next.load());
+    }
+    if(holds(curr, key) && !is_marked(curr->next.load())){
+        return curr;
+    }
+    return NULL;
+}
+
+/**
+    Performs search to find if a node exists.
+    Return value if the key found, else return a default constructed value
+*/
+template <typename Key, typename Value, typename Compare>
+Value NoHotSpotSkipList<Key, Value, Compare>::search(const Key &key){
+    Value value = Value();
+    search(key, [&value](const Value &v){ value = v; });
+    return value;
+}
+
+/**
+    Performs a search without writes and passes a reference to the value to on_found, without copying it.
+    The reference is only valid inside on_found.
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+bool NoHotSpotSkipList<Key, Value, Compare>::search(const Key &key, Function on_found){
+    EpochGuard guard;
+
+    node_type *node = lookup(key);
+    if(node == NULL){
+        return false;
+    }
+    on_found(node->get_value());
+    return true;
+}
+
+/**
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+bool NoHotSpotSkipList<Key, Value, Compare>::contains(const Key &key){
+    EpochGuard guard;
+    return lookup(key) != NULL;
+}
+
+/**
+    Walks level 0 from the index and passes every key and value between start_key and end_key
+    to visitor, without copying them. Deleted nodes are skipped. Stops after limit pairs.
+    The references are only valid inside visitor.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+size_t NoHotSpotSkipList<Key, Value, Compare>::scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit){
+    if(compare(end_key, start_key)){
+        return 0;
+    }
+
+    EpochGuard guard;
+
+    node_type *curr = get_node(start(start_key)->next.load());
+    while(before(curr, start_key)){
+        curr = get_node(curr->next.load());
+    }
+
+    size_t count = 0;
+    while(count < limit && curr != tail && !compare(end_key, curr->get_key())){
+        uintptr_t next = curr->next.load();
+        if(!is_marked(next)){
+            visitor(curr->get_key(), curr->get_value());
+            count++;
+        }
+        curr = get_node(next);
+    }
+    return count;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key in a map.
+    Use scan to read a range without copying it.
+*/
+template <typename Key, typename Value, typename Compare>
+map<Key, Value, Compare> NoHotSpotSkipList<Key, Value, Compare>::range(const Key &start_key, const Key &end_key){
+    map<Key, Value, Compare> range_output(compare);
+    scan(start_key, end_key, [&range_output](const Key &key, const Value &value){
+        range_output.insert(range_output.end(), make_pair(key, value));
+    });
+    return range_output;
+}
+
+/**
+    Walks level 0 from the head to the tail.
+    Returns the number of nodes not deleted.
+*/
+template <typename Key, typename Value, typename Compare>
+size_t NoHotSpotSkipList<Key, Value, Compare>::size(){
+    EpochGuard guard;
+
+    size_t count = 0;
+    for (node_type *curr = get_node(head->next.load()); curr != tail; ){
+        uintptr_t next = curr->next.load();
+        if(!is_marked(next)){
+            count++;
+        }
+        curr = get_node(next);
+    }
+    return count;
+}
+
+/**
+    Walks level 0 once, unlinking the deleted nodes it passes, and publishes a new index of the nodes it kept.
+    The nodes unlinked before the walk are not in the new index. They are retired together with the previous
+    index, the last place a new search could find them in.
+*/
+template <typename Key, typename Value, typename Compare>
+void NoHotSpotSkipList<Key, Value, Compare>::rebuild(){
+    node_type *retired = unlinked.exchange(NULL);
+
+    EpochGuard guard;
+
+    // The first replica is built during the walk, the others are copied from it on their own node
+    Index *current = index[0].load(memory_order_relaxed);
+    Index *next_index = new Index(replicas == 1 ? -1 : 0);
+    if(current != NULL){
+        next_index->keys.reserve(current->keys.size() + current->keys.size() / 4);
+        next_index->nodes.reserve(current->nodes.size() + current->nodes.size() / 4);
+    }
+
+    size_t position = 0;
+    node_type *pred = head;
+    node_type *curr = get_node(head->next.load());
+    while(curr != tail){
+        uintptr_t succ = curr->next.load();
+        if(is_marked(succ)){
+            uintptr_t expected = make_reference(curr, false);
+            if(pred->next.compare_exchange_strong(expected, make_reference(get_node(succ), false))){
+                curr->next_unlinked = retired;
+                retired = curr;
+            }
+            curr = get_node(succ);
+            continue;
+        }
+
+        if(position++ % INDEX_STRIDE == 0){
+            next_index->keys.push_back(curr->get_key());
+            next_index->nodes.push_back(curr);
+        }
+        pred = curr;
+        curr = get_node(succ);
+    }
+
+    for (int i = replicas - 1; i >= 0; i--){
+        Index *replica = next_index;
+        if(i > 0){
+            replica = new Index(i);
+            replica->keys.assign(next_index->keys.begin(), next_index->keys.end());
+            replica->nodes.assign(next_index->nodes.begin(), next_index->nodes.end());
+        }
+        Index *previous = index[i].exchange(replica, memory_order_acq_rel);
+
+        // Searches that started before the publication may still be on the previous index or the retired nodes
+        if(previous != NULL){
+            EpochManager::retire(previous);
+        }
+    }
+    while(retired != NULL){
+        node_type *node = retired;
+        retired = retired->next_unlinked;
+        EpochManager::retire(node);
+    }
+}
+
+/**
+    Body of the maintenance thread. Rebuilds the index whenever the list changed since the last rebuild.
+*/
+template <typename Key, typename Value, typename Compare>
+void NoHotSpotSkipList<Key, Value, Compare>::maintain(){
+    while(!stopping.load()){
+        if(changed.load(memory_order_relaxed)){
+            changed.store(false, memory_order_relaxed);
+            rebuild();
+        }
+        this_thread::sleep_for(chrono::microseconds(REBUILD_PAUSE_US));
+    }
+}
+
+/**
+    Display the skip list in readable format, the indexed keys and then level 0
+*/
+template <typename Key, typename Value, typename Compare>
+void NoHotSpotSkipList<Key, Value, Compare>::display(){
+    EpochGuard guard;
+
+    Index *current = index[0].load(memory_order_acquire);
+    cout << "Index  head -> ";
+    if(current != NULL){
+        for (size_t i = 0; i < current->keys.size(); i++){
+            cout << current->keys[i] << " -> ";
+        }
+    }
+    cout << "tail" << endl;
+
+    cout << "Level 0  head -> ";
+    for (node_type *temp = get_node(head->next.load()); temp != tail; temp = get_node(temp->next.load())){
+        if(!is_marked(temp->next.load())){
+            cout << temp->get_key() << " -> ";
+        }
+    }
+    cout << "tail" << endl;
+    printf("---------- Display done! ----------\n\n");
+}
+
+#endif
@@ -1,35 +1,116 @@
-#include <vector>
-#include <mutex>
-#include <thread>
+#ifndef NODE_H
+#define NODE_H
+
+#include <new>
 #include <atomic>
+#include <stdint.h>
 #include "key_value_pair.h"
+#include "node_allocator.h"
+#include "spin_wait.h"
 
+/**
+    One Node of the Skip list, allocated as a single block sized to its top level.
+    The flags, lock word and key come first and the tower of next references is stored inline at the end,
+    so a traversal reads the key and next[level] from the same cache line instead of following a separate vector.
+    Nodes are created with Node::create and freed with Node::destroy.
+*/
+template <typename Key, typename Value>
 class Node{
     public:
-        // Stores the key and value for the Node
-        KeyValuePair key_value_pair;
-
-        // Stores the reference of the next node until the top level for the node
-        vector<Node*> next;
+        // The Maximum level until which the node is available
+        int top_level;
 
-        // Lock to lock the node when modifing it
-        mutex node_lock;
+        // Lock word to lock the node when modifing it, see WordLock
+        atomic<uint32_t> lock_word;
 
         // Atomic variable to be marked if this Node is being deleted
-        atomic<bool> marked = {false};
+        atomic<bool> marked;
 
         // Atomic variable to indicate the Node is completely linked to predecessors and successors
-        atomic<bool> fully_linked = {false};
+        atomic<bool> fully_linked;
 
-        // The Maximum level until which the node is available
-        int top_level; 
-
-        Node();
-        Node(int key, int level);
-        Node(int key, string value, int level);
-        ~Node();
-        int get_key();
-        string get_value();
+        // Stores the key and value for the Node
+        KeyValuePair<Key, Value> key_value_pair;
+
+        // Stores the reference of the next node until the top level for the node
+        Node *next[];
+
+        static Node *create(const Key &key, const Value &value, int level);
+        static void destroy(Node *node);
+
+        const Key &get_key() const{
+            return key_value_pair.get_key();
+        }
+        const Value &get_value() const{
+            return key_value_pair.get_value();
+        }
         void lock();
         void unlock();
-};
\ No newline at end of file
+
+    private:
+        Node(const Key &key, const Value &value, int level);
+        Node(const Node &);
+        Node &operator=(const Node &);
+
+        static size_t block_size(int level){
+            return sizeof(Node) + (level + 1) * sizeof(Node *);
+        }
+};
+
+/**
+    Allocates a Node with room for level + 1 next references in the same block.
+    Blocks come from the node allocator and start on a cache line boundary,
+    so the key and the lowest levels of the tower share the first line.
+*/
+template <typename Key, typename Value>
+Node<Key, Value> *Node<Key, Value>::create(const Key &key, const Value &value, int level){
+    void *memory = NodeAllocator::allocate(block_size(level));
+    try{
+        return new (memory) Node(key, value, level);
+    }catch(...){
+        NodeAllocator::deallocate(memory, block_size(level));
+        throw;
+    }
+}
+
+/**
+    Frees a Node allocated with create
+*/
+template <typename Key, typename Value>
+void Node<Key, Value>::destroy(Node *node){
+    if(node == NULL){
+        return;
+    }
+    int level = node->top_level;
+    node->~Node();
+    NodeAllocator::deallocate(node, block_size(level));
+}
+
+/**
+    Constructor
+*/
+template <typename Key, typename Value>
+Node<Key, Value>::Node(const Key &key, const Value &value, int level) : top_level(level), lock_word(0),
+        marked(false), fully_linked(false), key_value_pair(key, value){
+    for (int i = 0; i <= level; i++){
+        next[i] = NULL;
+    }
+}
+
+/**
+    Locks the node. Spins with backoff while it is held, then parks until the holder releases it.
+*/
+template <typename Key, typename Value>
+void Node<Key, Value>::lock(){
+    WordLock::lock(lock_word);
+}
+
+/**
+    Unlocks the node and wakes a parked waiter
+*/
+template <typename Key, typename Value>
+void Node<Key, Value>::unlock(){
+    WordLock::unlock(lock_word);
+}
+
+#endif
@@ -0,0 +1,306 @@
+/**
+    Per thread slab allocator for skip list nodes
+*/
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "node_allocator.h"
+#include "numa_support.h"
+
+using namespace std;
+
+/**
+    A free block, linked through its first word
+*/
+struct FreeBlock{
+    FreeBlock *next;
+};
+
+/**
+    First cache line of every slab. Slabs are aligned to their size, so the header of a block is found by masking its address.
+*/
+struct SlabHeader{
+    // NUMA node the slab is bound to
+    int node;
+};
+
+// Blocks freed on another NUMA node than their own are handed back to their node in batches of this size
+#define REMOTE_BATCH 64
+
+/**
+    Free lists and the current chunk of a thread.
+    Trivially destructible, so it stays usable while other thread local objects are destroyed.
+*/
+struct ThreadCache{
+    FreeBlock *free_list[NodeAllocator::NUM_CLASSES];
+    char *chunk;
+    char *chunk_end;
+
+    // Blocks of other NUMA nodes freed by this thread, waiting to go back to their node's pool
+    FreeBlock *remote[NumaSupport::MAX_NODES][NodeAllocator::NUM_CLASSES];
+    size_t remote_count[NumaSupport::MAX_NODES][NodeAllocator::NUM_CLASSES];
+
+    // Set once the owner is registered, the owner flushes the lists when the thread exits
+    bool registered;
+
+    // Set after the flush, blocks freed afterwards go straight to the shared pool
+    bool exited;
+};
+
+static thread_local ThreadCache cache;
+
+/**
+    Shared pool of free blocks of a NUMA node and the slab chunks are carved from.
+    Without the NUMA aware mode everything comes from the pool of node 0.
+*/
+struct NodePool{
+    FreeBlock *pool[NodeAllocator::NUM_CLASSES];
+    char *slab;
+    char *slab_end;
+};
+
+static mutex pool_lock;
+static NodePool pools[NumaSupport::MAX_NODES];
+
+static atomic<bool> huge_pages(false);
+
+/**
+    Returns the size class of a block, the number of cache lines it needs minus one
+*/
+static inline size_t size_class(size_t size){
+    return (size + NodeAllocator::CACHE_LINE_SIZE - 1) / NodeAllocator::CACHE_LINE_SIZE - 1;
+}
+
+/**
+    Pushes a chain of blocks from first to last onto the shared pool of a class.
+    Must be called with pool_lock held.
+*/
+static void push_pool(int node, size_t cls, FreeBlock *first, FreeBlock *last){
+    last->next = pools[node].pool[cls];
+    pools[node].pool[cls] = first;
+}
+
+static inline int slab_node(void *block){
+    uintptr_t slab = reinterpret_cast<uintptr_t>(block) & ~(uintptr_t)(NodeAllocator::SLAB_SIZE - 1);
+    return reinterpret_cast<SlabHeader *>(slab)->node;
+}
+
+/**
+    Hands the remote blocks of a class back to the pool of their node.
+    Must be called with pool_lock held.
+*/
+static void flush_remote(ThreadCache &local, int node, size_t cls){
+    FreeBlock *first = local.remote[node][cls];
+    if (first == NULL){
+        return;
+    }
+    FreeBlock *last = first;
+    while (last->next != NULL){
+        last = last->next;
+    }
+    push_pool(node, cls, first, last);
+    local.remote[node][cls] = NULL;
+    local.remote_count[node][cls] = 0;
+}
+
+/**
+    Hands the free lists of the thread to the shared pool when the thread exits
+*/
+struct CacheOwner{
+    void touch(){
+    }
+
+    ~CacheOwner(){
+        lock_guard<mutex> guard(pool_lock);
+        for (size_t cls = 0; cls < NodeAllocator::NUM_CLASSES; cls++){
+            FreeBlock *first = cache.free_list[cls];
+            if (first == NULL){
+                continue;
+            }
+            FreeBlock *last = first;
+            while (last->next != NULL){
+                last = last->next;
+            }
+            push_pool(slab_node(first), cls, first, last);
+            cache.free_list[cls] = NULL;
+        }
+        for (int node = 0; node < NumaSupport::MAX_NODES; node++){
+            for (size_t cls = 0; cls < NodeAllocator::NUM_CLASSES; cls++){
+                flush_remote(cache, node, cls);
+            }
+        }
+        cache.exited = true;
+    }
+};
+
+static thread_local CacheOwner owner;
+
+static inline ThreadCache &get_cache(){
+    if (!cache.registered){
+        cache.registered = true;
+        owner.touch();
+    }
+    return cache;
+}
+
+/**
+    Maps a size aligned region. With huge pages, a transparent huge page hint is given.
+*/
+static char *map_aligned(size_t size){
+    // Map twice the size and trim it to an aligned slab
+    void *mapping = mmap(NULL, 2 * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED){
+        throw bad_alloc();
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned = (start + size - 1) & ~(uintptr_t)(size - 1);
+    if (aligned > start){
+        munmap(mapping, aligned - start);
+    }
+    munmap(reinterpret_cast<void *>(aligned + size), start + size - aligned);
+#ifdef MADV_HUGEPAGE
+    if (huge_pages.load()){
+        madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+    }
+#endif
+    return reinterpret_cast<char *>(aligned);
+}
+
+/**
+    Maps a new slab for a NUMA node and writes its header. With huge pages, a hugetlbfs mapping is tried first,
+    then a transparent huge page hint. The pages are bound to the node before they are touched.
+*/
+static char *map_slab(int node){
+    size_t size = NodeAllocator::SLAB_SIZE;
+    char *slab = NULL;
+
+#ifdef MAP_HUGETLB
+    if (huge_pages.load()){
+        void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED){
+            if ((reinterpret_cast<uintptr_t>(memory) & (size - 1)) == 0){
+                slab = static_cast<char *>(memory);
+            }else{
+                munmap(memory, size);
+            }
+        }
+    }
+#endif
+    if (slab == NULL){
+        slab = map_aligned(size);
+    }
+
+    if (NumaSupport::enabled()){
+        NumaSupport::bind(slab, size, node);
+    }
+    reinterpret_cast<SlabHeader *>(slab)->node = node;
+    return slab;
+}
+
+/**
+    Refills the thread's free list of a class from the shared pool, or else carves a block from the thread's chunk.
+    Returns the carved block, or NULL if the free list was refilled.
+*/
+static void *refill(ThreadCache &local, size_t cls){
+    size_t size = (cls + 1) * NodeAllocator::CACHE_LINE_SIZE;
+
+    if (local.chunk == NULL || local.chunk + size > local.chunk_end){
+        int node = NumaSupport::enabled() ? NumaSupport::current_node() : 0;
+        NodePool &shared = pools[node];
+
+        lock_guard<mutex> guard(pool_lock);
+        if (shared.pool[cls] != NULL){
+            local.free_list[cls] = shared.pool[cls];
+            shared.pool[cls] = NULL;
+            return NULL;
+        }
+        if (shared.slab == NULL || shared.slab + size > shared.slab_end){
+            char *slab = map_slab(node);
+            shared.slab = slab + NodeAllocator::CACHE_LINE_SIZE;
+            shared.slab_end = slab + NodeAllocator::SLAB_SIZE;
+        }
+        // The first chunk of a slab is one line shorter, for the header
+        local.chunk = shared.slab;
+        local.chunk_end = (char *)(((uintptr_t)shared.slab + NodeAllocator::CHUNK_SIZE) & ~(uintptr_t)(NodeAllocator::CHUNK_SIZE - 1));
+        shared.slab = local.chunk_end;
+    }
+
+    void *block = local.chunk;
+    local.chunk += size;
+    return block;
+}
+
+/**
+    Returns a cache line aligned block of at least size bytes
+*/
+void *NodeAllocator::allocate(size_t size){
+    size_t cls = size_class(size);
+    if (cls >= NUM_CLASSES){
+        // Larger than any class, such as a node with a big inline value, comes from the heap
+        void *memory = NULL;
+        if (posix_memalign(&memory, CACHE_LINE_SIZE, size) != 0){
+            throw bad_alloc();
+        }
+        return memory;
+    }
+
+    ThreadCache &local = get_cache();
+    FreeBlock *block = local.free_list[cls];
+    if (block == NULL){
+        void *carved = refill(local, cls);
+        if (carved != NULL){
+            return carved;
+        }
+        block = local.free_list[cls];
+    }
+    local.free_list[cls] = block->next;
+    return block;
+}
+
+/**
+    Returns a block of the given size to the free list of the calling thread.
+    In the NUMA aware mode a block of another node goes back to the pool of its node.
+*/
+void NodeAllocator::deallocate(void *memory, size_t size){
+    if (memory == NULL){
+        return;
+    }
+    size_t cls = size_class(size);
+    if (cls >= NUM_CLASSES){
+        free(memory);
+        return;
+    }
+    FreeBlock *block = static_cast<FreeBlock *>(memory);
+
+    ThreadCache &local = get_cache();
+    if (local.exited){
+        lock_guard<mutex> guard(pool_lock);
+        push_pool(slab_node(block), cls, block, block);
+        return;
+    }
+    if (NumaSupport::enabled()){
+        int node = slab_node(block);
+        if (node != NumaSupport::current_node()){
+            block->next = local.remote[node][cls];
+            local.remote[node][cls] = block;
+            if (++local.remote_count[node][cls] == REMOTE_BATCH){
+                lock_guard<mutex> guard(pool_lock);
+                flush_remote(local, node, cls);
+            }
+            return;
+        }
+    }
+    block->next = local.free_list[cls];
+    local.free_list[cls] = block;
+}
+
+/**
+    Enables or disables huge pages for the slabs allocated from now on
+*/
+void NodeAllocator::set_huge_pages(bool enabled){
+    huge_pages.store(enabled);
+}
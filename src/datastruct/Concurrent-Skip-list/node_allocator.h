@@ -0,0 +1,39 @@
+#ifndef NODE_ALLOCATOR_H
+#define NODE_ALLOCATOR_H
+
+#include <stddef.h>
+
+/**
+    Slab allocator for skip list nodes.
+    Blocks are rounded up to whole cache lines, one size class per number of lines, so every class
+    covers the tower heights that fit in that many lines. Every thread keeps a free list per class and
+    carves new blocks from its own chunk of a shared slab, so the common path takes no lock.
+    A freed block goes to the free list of the thread that frees it, which for removed nodes is the
+    thread running the epoch reclaimer, and is reused by that thread's next insert.
+    Blocks are never returned to the system, the lists of exiting threads are handed to a shared pool.
+    Blocks larger than the largest class are allocated from the heap.
+    In the NUMA aware mode (numa_support.h) every node has its own slabs and pool, a thread carves its chunks
+    from the slabs of the node it runs on, and a block freed on another node is returned to its own node.
+*/
+class NodeAllocator{
+    public:
+        // Size and alignment of a block unit
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        // Number of size classes, the largest one holds blocks of NUM_CLASSES cache lines
+        static const size_t NUM_CLASSES = 16;
+
+        // Size of the slabs requested from the system, a multiple of the huge page size
+        static const size_t SLAB_SIZE = 2 * 1024 * 1024;
+
+        // Size of the pieces of a slab handed to a thread at a time
+        static const size_t CHUNK_SIZE = 64 * 1024;
+
+        static void *allocate(size_t size);
+        static void deallocate(void *block, size_t size);
+
+        // Backs slabs allocated from now on with huge pages when the system provides them
+        static void set_huge_pages(bool enabled);
+};
+
+#endif
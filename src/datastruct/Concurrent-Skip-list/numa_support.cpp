@@ -0,0 +1,166 @@
+/**
+    NUMA placement through libnuma, with a single node fallback
+*/
+
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+#include "numa_support.h"
+
+#ifdef USE_LIBNUMA
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+static atomic<bool> numa_enabled(false);
+
+// Node the calling thread was restricted to, -1 while it may run anywhere
+static thread_local int pinned_node = -1;
+
+bool NumaSupport::available(){
+#ifdef USE_LIBNUMA
+    static bool has_numa = numa_available() >= 0;
+    return has_numa;
+#else
+    return false;
+#endif
+}
+
+bool NumaSupport::set_enabled(bool enabled){
+    if (enabled && !available()){
+        return false;
+    }
+    numa_enabled.store(enabled);
+    return true;
+}
+
+bool NumaSupport::enabled(){
+    return numa_enabled.load(memory_order_relaxed);
+}
+
+/**
+    Returns the highest node number plus one, capped at MAX_NODES
+*/
+int NumaSupport::num_nodes(){
+#ifdef USE_LIBNUMA
+    if (available()){
+        static int nodes = numa_max_node() + 1;
+        return nodes < MAX_NODES ? nodes : MAX_NODES;
+    }
+#endif
+    return 1;
+}
+
+/**
+    Returns the node the thread was pinned to, or else the node of the cpu it runs on right now
+*/
+int NumaSupport::current_node(){
+    if (pinned_node >= 0){
+        return pinned_node;
+    }
+#ifdef USE_LIBNUMA
+    if (available()){
+        int cpu = sched_getcpu();
+        int node = cpu < 0 ? 0 : numa_node_of_cpu(cpu);
+        return node < 0 ? 0 : node % num_nodes();
+    }
+#endif
+    return 0;
+}
+
+bool NumaSupport::run_on_node(int node){
+#ifdef USE_LIBNUMA
+    if (available() && numa_run_on_node(node) == 0){
+        pinned_node = node % num_nodes();
+        return true;
+    }
+#else
+    (void) node;
+#endif
+    return false;
+}
+
+#ifdef USE_LIBNUMA
+/**
+    Requests below a page come from the heap, libnuma maps whole pages
+*/
+static bool page_sized(size_t size){
+    static size_t page_size = sysconf(_SC_PAGESIZE);
+    return size >= page_size;
+}
+#endif
+
+void *NumaSupport::allocate_on(size_t size, int node){
+#ifdef USE_LIBNUMA
+    if (available() && page_sized(size)){
+        void *memory = node >= 0 ? numa_alloc_onnode(size, node) : numa_alloc(size);
+        if (memory == NULL){
+            throw bad_alloc();
+        }
+        return memory;
+    }
+#else
+    (void) node;
+#endif
+    void *memory = malloc(size);
+    if (memory == NULL){
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+/**
+    Frees memory from allocate_on, size must be the size it was allocated with
+*/
+void NumaSupport::deallocate(void *memory, size_t size){
+    if (memory == NULL){
+        return;
+    }
+#ifdef USE_LIBNUMA
+    if (available() && page_sized(size)){
+        numa_free(memory, size);
+        return;
+    }
+#else
+    (void) size;
+#endif
+    free(memory);
+}
+
+void NumaSupport::bind(void *memory, size_t size, int node){
+#ifdef USE_LIBNUMA
+    if (available()){
+        numa_tonode_memory(memory, size, node);
+    }
+#else
+    (void) memory;
+    (void) size;
+    (void) node;
+#endif
+}
+
+/**
+    Asks the kernel where the pages are, without moving them
+*/
+void NumaSupport::nodes_of(const vector<const void *> &addresses, vector<int> &nodes){
+    nodes.assign(addresses.size(), -1);
+#ifdef USE_LIBNUMA
+    if (available() && !addresses.empty()){
+        vector<void *> pages(addresses.size());
+        uintptr_t mask = ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1);
+        for (size_t i = 0; i < addresses.size(); i++){
+            pages[i] = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(addresses[i]) & mask);
+        }
+        if (numa_move_pages(0, pages.size(), &pages[0], NULL, &nodes[0], 0) != 0){
+            nodes.assign(addresses.size(), -1);
+        }
+        for (size_t i = 0; i < nodes.size(); i++){
+            if (nodes[i] < 0){
+                nodes[i] = -1;
+            }
+        }
+    }
+#endif
+}
@@ -0,0 +1,92 @@
+#ifndef NUMA_SUPPORT_H
+#define NUMA_SUPPORT_H
+
+#include <new>
+#include <vector>
+#include <stddef.h>
+
+using namespace std;
+
+/**
+    NUMA placement shared by the node allocator and the skip lists.
+    Built on libnuma when compiled with USE_LIBNUMA and linked with -lnuma, otherwise the machine is one node.
+    The NUMA aware mode is off by default. Once enabled, slabs of the node allocator are bound to the node
+    of the thread that carves them and lists that keep an index replicate it on every node.
+*/
+class NumaSupport{
+    public:
+        // Nodes beyond this number share the pools of the lower nodes
+        static const int MAX_NODES = 8;
+
+        // Returns true if the system reports a NUMA topology through libnuma
+        static bool available();
+
+        // Turns the NUMA aware mode on or off, returns false and stays off if libnuma is not available
+        static bool set_enabled(bool enabled);
+        static bool enabled();
+
+        // Number of nodes with memory, 1 when libnuma is not available
+        static int num_nodes();
+
+        // Node the calling thread runs on, in [0, num_nodes())
+        static int current_node();
+
+        // Restricts the calling thread to the cpus of a node
+        static bool run_on_node(int node);
+
+        // Memory for data on one node, a node below 0 means anywhere
+        static void *allocate_on(size_t size, int node);
+        static void deallocate(void *memory, size_t size);
+
+        // Places the pages of memory that are not touched yet on a node
+        static void bind(void *memory, size_t size, int node);
+
+        // Writes the node holding the page of every address to nodes, -1 where it is unknown
+        static void nodes_of(const vector<const void *> &addresses, vector<int> &nodes);
+};
+
+/**
+    Allocator placing the elements of a container on one node, for data every thread of that node reads
+*/
+template <typename T>
+class NumaAllocator{
+    public:
+        typedef T value_type;
+
+        int node;
+
+        explicit NumaAllocator(int node = -1) : node(node){
+        }
+
+        template <typename U>
+        NumaAllocator(const NumaAllocator<U> &other) : node(other.node){
+        }
+
+        // Without a node the elements come from the heap like with the default allocator
+        T *allocate(size_t n){
+            if(node < 0){
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            }
+            return static_cast<T *>(NumaSupport::allocate_on(n * sizeof(T), node));
+        }
+
+        void deallocate(T *memory, size_t n){
+            if(node < 0){
+                ::operator delete(memory);
+                return;
+            }
+            NumaSupport::deallocate(memory, n * sizeof(T));
+        }
+};
+
+template <typename T, typename U>
+bool operator==(const NumaAllocator<T> &a, const NumaAllocator<U> &b){
+    return a.node == b.node;
+}
+
+template <typename T, typename U>
+bool operator!=(const NumaAllocator<T> &a, const NumaAllocator<U> &b){
+    return a.node != b.node;
+}
+
+#endif
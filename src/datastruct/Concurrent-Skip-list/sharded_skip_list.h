@@ -0,0 +1,424 @@
+#ifndef SHARDED_SKIP_LIST_H
+#define SHARDED_SKIP_LIST_H
+
+/**
+    Implements a skip list split into range partitions, each one its own skip list
+*/
+
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include <stdio.h>
+#include "skip_list.h"
+#include "epoch.h"
+
+/**
+    Ordered map split by key ranges into shards, each one a BasicSkipList with its own head.
+    Shard i holds the keys from split i - 1 up to split i, the first and last shard are open ended.
+    Point operations search the splits and run on one shard, so threads working on different ranges
+    never traverse the same head. Scans walk the shards in order and stitch their ranges together.
+
+    The splits and shards form a layout that is replaced as a whole and retired through the epoch manager.
+    A shard holding more than split_size keys is split online at its median key:
+    its writers wait while the upper half is copied to a new shard and the new layout is published,
+    searches and scans continue meanwhile.
+*/
+template <typename Key, typename Value, typename Compare = less<Key> >
+class ShardedSkipList{
+    public:
+        typedef BasicSkipList<Key, Value, Compare> shard_type;
+
+        // The size of a shard is counted by one successful update in SIZE_SAMPLE, chosen at random, adding SIZE_SAMPLE
+        static const long SIZE_SAMPLE = 16;
+
+    private:
+        struct Shard{
+            shard_type list;
+
+            // Set while the shard is split, its writers wait until it is cleared
+            atomic<bool> frozen;
+
+            // Estimated number of keys, updated by sampled updates so they do not all write the same line
+            atomic<long> approx_size;
+
+            Shard(int max_elements, float probability, const Compare &compare)
+                    : list(max_elements, probability, compare), frozen(false), approx_size(0){
+            }
+        };
+
+        /**
+            Splits in order and the shards between them, shards.size() == splits.size() + 1. Never changed once published.
+        */
+        struct Layout{
+            vector<Key> splits;
+            vector<Shard *> shards;
+        };
+
+        atomic<Layout *> layout;
+
+        // Every shard ever created, freed with the list
+        vector<Shard *> all_shards;
+
+        // Serializes splits
+        mutex split_lock;
+
+        int max_elements;
+        float probability;
+        Compare compare;
+        long split_size;
+
+        /**
+            Returns the index of the shard holding key
+        */
+        size_t route(const Layout *current, const Key &key){
+            return upper_bound(current->splits.begin(), current->splits.end(), key, compare) - current->splits.begin();
+        }
+
+        /**
+            Returns true if key belongs to a shard after shard i. A shard being split still holds the keys of its upper half.
+        */
+        bool past_shard(const Layout *current, size_t i, const Key &key){
+            return i < current->splits.size() && !compare(key, current->splits[i]);
+        }
+
+        /**
+            Returns true for one call in SIZE_SAMPLE on average
+        */
+        static bool sample(){
+            static thread_local uint32_t state = 0;
+            if(state == 0){
+                state = (uint32_t) hash<thread::id>()(this_thread::get_id()) | 1;
+            }
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state % SIZE_SAMPLE == 0;
+        }
+
+        template <typename Function>
+        size_t scan_shard(const Layout *current, size_t i, Function visitor);
+        void split(Shard *shard);
+
+        ShardedSkipList(const ShardedSkipList &);
+        ShardedSkipList &operator=(const ShardedSkipList &);
+
+    public:
+        ShardedSkipList(const vector<Key> &splits, int max_elements, float probability, long split_size = 0, const Compare &compare = Compare());
+        ~ShardedSkipList();
+
+        // Supported operations
+        bool add(const Key &key, const Value &value);
+        Value search(const Key &key);
+        bool contains(const Key &key);
+        template <typename Function>
+        bool search(const Key &key, Function on_found);
+        bool remove(const Key &key);
+        map<Key, Value, Compare> range(const Key &start_key, const Key &end_key);
+        template <typename Function>
+        size_t scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit = numeric_limits<size_t>::max());
+        size_t size();
+        size_t shard_count();
+        void display();
+};
+
+template <typename Key, typename Value, typename Compare>
+const long ShardedSkipList<Key, Value, Compare>::SIZE_SAMPLE;
+
+/**
+    Constructor. Creates one shard more than there are splits, the splits must be in increasing order.
+    Every shard is sized for max_elements keys. A shard is split once it holds more than split_size keys,
+    0 keeps the shards fixed.
+*/
+template <typename Key, typename Value, typename Compare>
+ShardedSkipList<Key, Value, Compare>::ShardedSkipList(const vector<Key> &splits, int max_elements, float probability, long split_size, const Compare &compare)
+        : max_elements(max_elements), probability(probability), compare(compare), split_size(split_size){
+    Layout *initial = new Layout();
+    initial->splits = splits;
+    for (size_t i = 0; i <= splits.size(); i++){
+        Shard *shard = new Shard(max_elements, probability, compare);
+        initial->shards.push_back(shard);
+        all_shards.push_back(shard);
+    }
+    layout.store(initial);
+}
+
+/**
+    Frees the shards and the layout. No operation may run on the list any more.
+*/
+template <typename Key, typename Value, typename Compare>
+ShardedSkipList<Key, Value, Compare>::~ShardedSkipList(){
+    delete layout.load();
+    for (size_t i = 0; i < all_shards.size(); i++){
+        delete all_shards[i];
+    }
+}
+
+/**
+    Inserts the key into its shard, waiting while the shard is split.
+    Return if already exists.
+*/
+template <typename Key, typename Value, typename Compare>
+bool ShardedSkipList<Key, Value, Compare>::add(const Key &key, const Value &value){
+    while(true){
+        Shard *shard;
+        bool added;
+        {
+            EpochGuard guard;
+            Layout *current = layout.load(memory_order_acquire);
+            shard = current->shards[route(current, key)];
+            if(shard->frozen.load()){
+                shard = NULL;
+            }else{
+                added = shard->list.add(key, value);
+            }
+        }
+
+        // Shards are never freed while the list exists, the shard can be split after leaving the epoch
+        if(shard == NULL){
+            this_thread::yield();
+            continue;
+        }
+        if(added && sample()){
+            long size = shard->approx_size.fetch_add(SIZE_SAMPLE, memory_order_relaxed) + SIZE_SAMPLE;
+            if(split_size > 0 && size > split_size){
+                split(shard);
+            }
+        }
+        return added;
+    }
+}
+
+/**
+    Deletes the key from its shard, waiting while the shard is split.
+    Return if key doesn’t exist in the list.
+*/
+template <typename Key, typename Value, typename Compare>
+bool ShardedSkipList<Key, Value, Compare>::remove(const Key &key){
+    while(true){
+        {
+            EpochGuard guard;
+            Layout *current = layout.load(memory_order_acquire);
+            Shard *shard = current->shards[route(current, key)];
+            if(!shard->frozen.load()){
+                bool removed = shard->list.remove(key);
+                if(removed && sample()){
+                    shard->approx_size.fetch_sub(SIZE_SAMPLE, memory_order_relaxed);
+                }
+                return removed;
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+/**
+    Performs search to find if a node exists.
+    Return value if the key found, else return a default constructed value
+*/
+template <typename Key, typename Value, typename Compare>
+Value ShardedSkipList<Key, Value, Compare>::search(const Key &key){
+    Value value = Value();
+    search(key, [&value](const Value &v){ value = v; });
+    return value;
+}
+
+/**
+    Performs a search in the shard of key and passes a reference to the value to on_found.
+    Searches never wait for a split. The reference is only valid inside on_found.
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+bool ShardedSkipList<Key, Value, Compare>::search(const Key &key, Function on_found){
+    EpochGuard guard;
+    Layout *current = layout.load(memory_order_acquire);
+    return current->shards[route(current, key)]->list.search(key, on_found);
+}
+
+/**
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+bool ShardedSkipList<Key, Value, Compare>::contains(const Key &key){
+    EpochGuard guard;
+    Layout *current = layout.load(memory_order_acquire);
+    return current->shards[route(current, key)]->list.contains(key);
+}
+
+/**
+    Passes every key and value between start_key and end_key to visitor in key order, walking the shards
+    that cover the range one after the other. Stops after limit pairs.
+    The references are only valid inside visitor.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+size_t ShardedSkipList<Key, Value, Compare>::scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit){
+    if(compare(end_key, start_key)){
+        return 0;
+    }
+
+    EpochGuard guard;
+    Layout *current = layout.load(memory_order_acquire);
+
+    size_t count = 0;
+    for (size_t i = route(current, start_key); i < current->shards.size() && count < limit; i++){
+        if(i > 0 && compare(end_key, current->splits[i - 1])){
+            break;
+        }
+        size_t visited = 0;
+        current->shards[i]->list.scan(start_key, end_key, [&](const Key &key, const Value &value){
+            if(visited < limit - count && !past_shard(current, i, key)){
+                visitor(key, value);
+                visited++;
+            }
+        });
+        count += visited;
+    }
+    return count;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key in a map.
+    Use scan to read a range without copying it.
+*/
+template <typename Key, typename Value, typename Compare>
+map<Key, Value, Compare> ShardedSkipList<Key, Value, Compare>::range(const Key &start_key, const Key &end_key){
+    map<Key, Value, Compare> range_output(compare);
+    scan(start_key, end_key, [&range_output](const Key &key, const Value &value){
+        range_output.insert(range_output.end(), make_pair(key, value));
+    });
+    return range_output;
+}
+
+/**
+    Passes every key and value of shard i that belongs to it in the layout to visitor.
+    Returns the number of pairs visited. Must be called inside an epoch.
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+size_t ShardedSkipList<Key, Value, Compare>::scan_shard(const Layout *current, size_t i, Function visitor){
+    size_t count = 0;
+    current->shards[i]->list.scan_all([&](const Key &key, const Value &value){
+        if(!past_shard(current, i, key)){
+            visitor(key, value);
+            count++;
+        }
+    });
+    return count;
+}
+
+/**
+    Walks every shard.
+    Returns the number of keys in the list.
+*/
+template <typename Key, typename Value, typename Compare>
+size_t ShardedSkipList<Key, Value, Compare>::size(){
+    EpochGuard guard;
+    Layout *current = layout.load(memory_order_acquire);
+
+    size_t count = 0;
+    for (size_t i = 0; i < current->shards.size(); i++){
+        count += scan_shard(current, i, [](const Key &, const Value &){});
+    }
+    return count;
+}
+
+template <typename Key, typename Value, typename Compare>
+size_t ShardedSkipList<Key, Value, Compare>::shard_count(){
+    EpochGuard guard;
+    return layout.load(memory_order_acquire)->shards.size();
+}
+
+/**
+    Splits a shard at its median key, moving the upper half into a new shard right after it.
+    1. The shard is frozen and the writers that did not see the flag are waited for.
+    2. The upper half is copied into the new shard and a layout routing it there is published.
+    3. Once no operation can still use the previous layout, the upper half is removed from the shard and it is unfrozen.
+    Called by a writer outside an epoch. Returns at once if another split is running, the shard is split later.
+*/
+template <typename Key, typename Value, typename Compare>
+void ShardedSkipList<Key, Value, Compare>::split(Shard *shard){
+    unique_lock<mutex> guard(split_lock, try_to_lock);
+    if(!guard.owns_lock() || shard->approx_size.load() <= split_size){
+        return;
+    }
+
+    Layout *current = layout.load();
+    size_t position = find(current->shards.begin(), current->shards.end(), shard) - current->shards.begin();
+
+    shard->frozen.store(true);
+    EpochManager::synchronize();
+
+    vector<pair<Key, Value> > pairs;
+    {
+        EpochGuard epoch;
+        scan_shard(current, position, [&pairs](const Key &key, const Value &value){
+            pairs.push_back(make_pair(key, value));
+        });
+    }
+    size_t half = pairs.size() / 2;
+    if(half == 0){
+        shard->approx_size.store(pairs.size());
+        shard->frozen.store(false);
+        return;
+    }
+
+    vector<pair<Key, Value> > upper_pairs(pairs.begin() + half, pairs.end());
+    Shard *upper = new Shard(max_elements, probability, compare);
+    upper->list.add_batch(upper_pairs);
+    upper->approx_size.store(upper_pairs.size());
+    all_shards.push_back(upper);
+
+    Layout *next_layout = new Layout(*current);
+    next_layout->splits.insert(next_layout->splits.begin() + position, upper_pairs[0].first);
+    next_layout->shards.insert(next_layout->shards.begin() + position + 1, upper);
+    layout.store(next_layout, memory_order_release);
+    EpochManager::retire(current);
+
+    EpochManager::synchronize();
+
+    vector<Key> upper_keys;
+    upper_keys.reserve(upper_pairs.size());
+    for (size_t i = 0; i < upper_pairs.size(); i++){
+        upper_keys.push_back(upper_pairs[i].first);
+    }
+    shard->list.remove_batch(upper_keys);
+    shard->approx_size.store(half);
+    shard->frozen.store(false);
+}
+
+/**
+    Display every shard and the range it holds
+*/
+template <typename Key, typename Value, typename Compare>
+void ShardedSkipList<Key, Value, Compare>::display(){
+    EpochGuard guard;
+    Layout *current = layout.load(memory_order_acquire);
+
+    for (size_t i = 0; i < current->shards.size(); i++){
+        cout << "Shard " << i << " from ";
+        if(i == 0){
+            cout << "-inf";
+        }else{
+            cout << current->splits[i - 1];
+        }
+        cout << " to ";
+        if(i == current->splits.size()){
+            cout << "+inf";
+        }else{
+            cout << current->splits[i];
+        }
+        cout << endl;
+        current->shards[i]->list.display();
+    }
+}
+
+#endif
@@ -1,22 +1,1002 @@
+#ifndef SKIP_LIST_H
+#define SKIP_LIST_H
+
+/**
+    Implements the Concurrent Skip list data structure with insert, delete, search and range operations
+*/
+
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <math.h>
 #include <map>
+#include <vector>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
 #include "node.h"
+#include "epoch.h"
+#include "level_generator.h"
+
+/**
+    Skip list ordered by Compare on Key, storing a Value with every key.
+    The head and the tail are sentinels recognized by their address, so every value of Key can be stored.
+*/
+template <typename Key, typename Value, typename Compare = less<Key> >
+class BasicSkipList{
+    public:
+        typedef Node<Key, Value> node_type;
+
+        // Upper bound of max_level, sizes the predecessor and successor arrays
+        static const int MAX_LEVEL = 32;
 
-class SkipList{
     private:
         // Head and Tail of the Skiplist
-        Node *head;
-        Node *tail;
+        node_type *head;
+        node_type *tail;
+
+        // Highest level a node can have in this list
+        int max_level;
+
+        // Draws the levels of new nodes with the probability of the list
+        LevelGenerator levels;
+
+        // Orders the keys
+        Compare compare;
+
+        // Set if add and remove start from the predecessors of the previous operation of the thread
+        bool finger_enabled;
+
+        /**
+            Predecessors cached by the last add or remove of a thread, and the list and epoch they belong to
+        */
+        struct Finger{
+            const BasicSkipList *list;
+            node_type *head;
+            uint64_t epoch;
+            node_type *preds[MAX_LEVEL + 1];
+        };
+
+        static Finger &thread_finger(){
+            static thread_local Finger finger;
+            return finger;
+        }
+
+        bool load_finger(node_type **preds);
+        void save_finger(node_type **preds);
+
+        node_type *lookup(const Key &key);
+        node_type *lower_bound(const Key &key);
+        int find_from(const Key &key, node_type **predecessors, node_type **successors, int min_level);
+        bool remove_from(const Key &key, node_type **preds, node_type **succs, bool use_finger);
+        bool link_run(node_type **preds, node_type **succs, node_type **run, size_t run_length);
+
+        /**
+            Returns true if the node comes before key in the list. The tail comes after every key.
+        */
+        bool before(node_type *node, const Key &key){
+            return node != tail && compare(node->get_key(), key);
+        }
+
+        /**
+            Returns true if the node holds key
+        */
+        bool holds(node_type *node, const Key &key){
+            return node != tail && !compare(key, node->get_key());
+        }
+
+        static void destroy_node(void *node){
+            node_type::destroy(static_cast<node_type *>(node));
+        }
+
+        static void unlock_nodes(node_type **nodes, int count){
+            for (int i = 0; i < count; i++){
+                nodes[i]->unlock();
+            }
+        }
+
     public:
-        SkipList();
-        SkipList(int max_elements, float probability);
-        ~SkipList();
+        // Most keys of a batch linked under one set of predecessor locks
+        static const size_t BATCH_RUN_LIMIT = 64;
+
+        class const_iterator;
+        class Scan;
+
+        BasicSkipList();
+        BasicSkipList(int max_elements, float probability, const Compare &compare = Compare());
+        ~BasicSkipList();
         int get_random_level();
+        void set_finger(bool enabled);
 
         // Supported operations
-        int find(int key, vector<Node*> &predecessors, vector<Node*> &successors);
-        bool add(int key, string value);
-        string search(int key);
-        bool remove(int key);
-        map<int, string> range(int start_key, int end_key);
+        int find(const Key &key, node_type **predecessors, node_type **successors);
+        bool add(const Key &key, const Value &value);
+        Value search(const Key &key);
+        bool contains(const Key &key);
+        template <typename Function>
+        bool search(const Key &key, Function on_found);
+        bool remove(const Key &key);
+        size_t add_batch(const vector<pair<Key, Value> > &batch);
+        size_t remove_batch(vector<Key> batch);
+        map<Key, Value, Compare> range(const Key &start_key, const Key &end_key);
+        template <typename Function>
+        size_t scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit = numeric_limits<size_t>::max());
+        template <typename Function>
+        size_t scan_all(Function visitor);
+        size_t size();
         void display();
-};
\ No newline at end of file
+};
+
+/**
+    Forward iterator over the pairs of a Scan, in key order.
+    Dereferencing gives a reference to the pair stored in the node, which stays valid while the Scan exists.
+*/
+template <typename Key, typename Value, typename Compare>
+class BasicSkipList<Key, Value, Compare>::const_iterator{
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef KeyValuePair<Key, Value> value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const value_type *pointer;
+        typedef const value_type &reference;
+
+        const_iterator() : list(NULL), node(NULL), end_key(NULL), remaining(0){
+        }
+
+        reference operator*() const{
+            return node->key_value_pair;
+        }
+        pointer operator->() const{
+            return &node->key_value_pair;
+        }
+        const Key &key() const{
+            return node->get_key();
+        }
+        const Value &value() const{
+            return node->get_value();
+        }
+
+        const_iterator &operator++(){
+            remaining--;
+            node = settle(node->next[0]);
+            return *this;
+        }
+        const_iterator operator++(int){
+            const_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const const_iterator &other) const{
+            return node == other.node;
+        }
+        bool operator!=(const const_iterator &other) const{
+            return node != other.node;
+        }
+
+    private:
+        friend class Scan;
+
+        BasicSkipList *list;
+        node_type *node;
+        const Key *end_key;
+        size_t remaining;
+
+        const_iterator(BasicSkipList *list, node_type *node, const Key *end_key, size_t limit)
+                : list(list), node(NULL), end_key(end_key), remaining(limit){
+            this->node = settle(node);
+        }
+
+        /**
+            Returns the first node from node on that is in the list and inside the range, else NULL
+        */
+        node_type *settle(node_type *node){
+            if(remaining == 0){
+                return NULL;
+            }
+            while(node != list->tail && !list->compare(*end_key, node->get_key())){
+                if(node->fully_linked && !node->marked){
+                    return node;
+                }
+                node = node->next[0];
+            }
+            return NULL;
+        }
+};
+
+/**
+    Walks level 0 from the first key not before start_key up to end_key, visiting at most limit pairs.
+    The scan stays inside an epoch for its lifetime, so nothing it can reach is freed and values are not copied.
+    Keep a Scan short lived, removed nodes are not reclaimed by any thread while it is open.
+*/
+template <typename Key, typename Value, typename Compare>
+class BasicSkipList<Key, Value, Compare>::Scan{
+    public:
+        Scan(BasicSkipList &list, const Key &start_key, const Key &end_key, size_t limit = numeric_limits<size_t>::max())
+                : end_key(end_key){
+            if(list.compare(end_key, start_key)){
+                first = const_iterator();
+            }else{
+                first = const_iterator(&list, list.lower_bound(start_key), &this->end_key, limit);
+            }
+        }
+
+        const_iterator begin() const{
+            return first;
+        }
+        const_iterator end() const{
+            return const_iterator();
+        }
+
+    private:
+        EpochGuard guard;
+        Key end_key;
+        const_iterator first;
+
+        Scan(const Scan &);
+        Scan &operator=(const Scan &);
+};
+
+// The skip list of integer keys and string values used by the programs in this directory
+typedef BasicSkipList<int, string> SkipList;
+
+/**
+    Constructor
+*/
+template <typename Key, typename Value, typename Compare>
+BasicSkipList<Key, Value, Compare>::BasicSkipList(int max_elements, float prob, const Compare &compare) : compare(compare), finger_enabled(false){
+    max_level = (int) round(log(max_elements) / log(1/prob)) - 1;
+    if (max_level < 0) max_level = 0;
+    if (max_level > MAX_LEVEL) max_level = MAX_LEVEL;
+    levels = LevelGenerator(max_level, prob);
+
+    head = node_type::create(Key(), Value(), max_level);
+    tail = node_type::create(Key(), Value(), max_level);
+
+    for (int i = 0; i <= max_level; i++) {
+        head->next[i] = tail;
+    }
+}
+
+template <typename Key, typename Value, typename Compare>
+BasicSkipList<Key, Value, Compare>::BasicSkipList(){
+    head = NULL;
+    tail = NULL;
+    max_level = 0;
+    finger_enabled = false;
+}
+
+template <typename Key, typename Value, typename Compare>
+BasicSkipList<Key, Value, Compare>::~BasicSkipList(){
+}
+
+/**
+    Finds the predecessors and successors at each level of where a given key exists or might exist.
+    Updates the references in the arrays, which must hold at least max_level + 1 entries.
+    Returns -1 if not the key does not exist.
+*/
+template <typename Key, typename Value, typename Compare>
+int BasicSkipList<Key, Value, Compare>::find(const Key &key, node_type **predecessors, node_type **successors){
+    int found = -1;
+    node_type *prev = head;
+
+    for (int level = max_level; level >= 0; level--){
+        node_type *curr = prev->next[level];
+
+        while (before(curr, key)){
+            prev = curr;
+            curr = prev->next[level];
+        }
+
+        if(found == -1 && holds(curr, key)){
+            found = level;
+        }
+
+        predecessors[level] = prev;
+        successors[level] = curr;
+    }
+    return found;
+}
+
+/**
+    Draws the top level of a new node, each level is reached with the probability given to the constructor.
+    This decides until which level a new Node is available.
+*/
+template <typename Key, typename Value, typename Compare>
+int BasicSkipList<Key, Value, Compare>::get_random_level(){
+    return levels.next();
+}
+
+/**
+    Makes add and remove of every thread start from the predecessors found by its previous add or remove,
+    which skips most of the descent from the head when a thread works on nearby keys.
+*/
+template <typename Key, typename Value, typename Compare>
+void BasicSkipList<Key, Value, Compare>::set_finger(bool enabled){
+    finger_enabled = enabled;
+}
+
+/**
+    Copies the finger of the calling thread into preds if it belongs to this list and is still safe to read.
+    The cached nodes were reached inside an epoch, so they cannot have been freed if the thread entered
+    the same epoch again. Marked nodes are skipped later by find_from. Must be called inside an epoch.
+    Returns false if there is no usable finger.
+*/
+template <typename Key, typename Value, typename Compare>
+bool BasicSkipList<Key, Value, Compare>::load_finger(node_type **preds){
+    if(!finger_enabled){
+        return false;
+    }
+    Finger &finger = thread_finger();
+    if(finger.list != this || finger.head != head || finger.epoch != EpochManager::get_entered_epoch()){
+        return false;
+    }
+    for (int level = 0; level <= max_level; level++){
+        preds[level] = finger.preds[level];
+    }
+    return true;
+}
+
+/**
+    Caches preds as the finger of the calling thread. Must be called inside the epoch they were found in.
+*/
+template <typename Key, typename Value, typename Compare>
+void BasicSkipList<Key, Value, Compare>::save_finger(node_type **preds){
+    if(!finger_enabled){
+        return;
+    }
+    Finger &finger = thread_finger();
+    finger.list = this;
+    finger.head = head;
+    finger.epoch = EpochManager::get_entered_epoch();
+    for (int level = 0; level <= max_level; level++){
+        finger.preds[level] = preds[level];
+    }
+}
+
+/**
+    Inserts into the Skip list at the appropriate place using locks.
+    Return if already exists.
+*/
+template <typename Key, typename Value, typename Compare>
+bool BasicSkipList<Key, Value, Compare>::add(const Key &key, const Value &value){
+
+    // Nodes seen during the insert must not be freed until it completes
+    EpochGuard guard;
+
+    // Get the level until which the new node must be available
+    int top_level = get_random_level();
+
+    // References of the predecessors and successors, filled in by find
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+
+    // The new node is created outside the critical section, on the first attempt that needs it
+    node_type* new_node = NULL;
+
+    // Start from the predecessors of the previous operation of this thread if there is a usable finger
+    bool use_finger = load_finger(preds);
+
+    // Waits a little longer after every failed attempt, so retrying threads stop hammering the same locks
+    Backoff backoff;
+
+    // Keep trying to insert the element into the list. In case predecessors and successors are changed,
+    // this loop helps to try the insert again
+    while(true){
+
+        // Find the predecessors and successors of where the key must be inserted
+        int found = use_finger ? find_from(key, preds, succs, top_level) : find(key, preds, succs);
+
+        // If found and marked, wait and continue insert
+        // If found and unmarked, wait until it is fully_linked and return. No insert needed
+        // If not found, go ahead with insert
+        if(found != -1){
+            node_type* node_found = succs[found];
+
+            if(!node_found->marked){
+                Backoff linking;
+                while(! node_found->fully_linked){
+                    linking.wait();
+                }
+                // The new node was never linked, nobody else can reference it
+                node_type::destroy(new_node);
+                save_finger(preds);
+                return false;
+            }
+            backoff.wait();
+            continue;
+        }
+
+        // Store all the Nodes which lock we acquire, at most one per level
+        // The same predecessor can appear at several consecutive levels, its lock is acquired only once
+        node_type* locked_nodes[MAX_LEVEL + 1];
+        int num_locked = 0;
+
+        if(new_node == NULL){
+            new_node = node_type::create(key, value, top_level);
+        }
+
+        // Traverse the skip list and try to acquire the lock of predecessor at every level
+        try{
+            node_type* pred;
+            node_type* succ;
+
+            // Used to check if the predecessor and successors are same from when we tried to read them before
+            bool valid = true;
+
+            for (int level = 0; valid && (level <= top_level); level++){
+                pred = preds[level];
+                succ = succs[level];
+
+                // If not already acquired lock, then acquire the lock
+                if(num_locked == 0 || locked_nodes[num_locked - 1] != pred){
+                    pred->lock();
+                    locked_nodes[num_locked++] = pred;
+                }
+
+                // If predecessor marked or if the predecessor and successors change, then abort and try again
+                valid = !(pred->marked.load(std::memory_order_seq_cst)) && !(succ->marked.load(std::memory_order_seq_cst)) && pred->next[level]==succ;
+            }
+
+            // Conditons are not met, release locks, abort and try again.
+            if(!valid){
+                unlock_nodes(locked_nodes, num_locked);
+                backoff.wait();
+                continue;
+            }
+
+            // All conditions satisfied, insert the Node as we have all the required locks
+            // Update the predecessor and successors
+            for (int level = 0; level <= top_level; level++){
+                new_node->next[level] = succs[level];
+            }
+
+            for (int level = 0; level <= top_level; level++){
+                preds[level]->next[level] = new_node;
+            }
+
+            // Mark the node as completely linked.
+            new_node->fully_linked = true;
+
+            // Release lock of all the nodes held once insert is complete
+            unlock_nodes(locked_nodes, num_locked);
+
+            // The new node precedes the next larger key at every level it is linked at
+            for (int level = 0; level <= top_level; level++){
+                preds[level] = new_node;
+            }
+            save_finger(preds);
+
+            return true;
+        }catch(const std::exception& e){
+            // If any exception occurs during the above insert, release locks of the held nodes and try again.
+            std::cerr << e.what() << '\n';
+            unlock_nodes(locked_nodes, num_locked);
+        }
+    }
+}
+
+/**
+    Traverses the skip list once from the top level down, without locks or predecessor bookkeeping.
+    Stops at the first level the key is seen at.
+    Returns the node if it is fully linked and unmarked, else NULL. Must be called inside an epoch.
+*/
+template <typename Key, typename Value, typename Compare>
+typename BasicSkipList<Key, Value, Compare>::node_type *BasicSkipList<Key, Value, Compare>::lookup(const Key &key){
+    node_type *pred = head;
+
+    for (int level = max_level; level >= 0; level--){
+        node_type *curr = pred->next[level];
+
+        while (before(curr, key)){
+            pred = curr;
+            curr = pred->next[level];
+        }
+
+        if(holds(curr, key)){
+            return (curr->fully_linked && !curr->marked) ? curr : NULL;
+        }
+    }
+    return NULL;
+}
+
+/**
+    Performs search to find if a node exists.
+    Return value if the key found, else return a default constructed value
+*/
+template <typename Key, typename Value, typename Compare>
+Value BasicSkipList<Key, Value, Compare>::search(const Key &key){
+    Value value = Value();
+    search(key, [&value](const Value &v){ value = v; });
+    return value;
+}
+
+/**
+    Performs a wait-free search and passes a reference to the value to on_found, without copying it.
+    The reference is only valid inside on_found.
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+bool BasicSkipList<Key, Value, Compare>::search(const Key &key, Function on_found){
+    EpochGuard guard;
+
+    node_type *node = lookup(key);
+    if(node == NULL){
+        return false;
+    }
+    on_found(node->get_value());
+    return true;
+}
+
+/**
+    Return true if the key found
+*/
+template <typename Key, typename Value, typename Compare>
+bool BasicSkipList<Key, Value, Compare>::contains(const Key &key){
+    EpochGuard guard;
+    return lookup(key) != NULL;
+}
+
+/**
+    Deletes from the Skip list at the appropriate place using locks.
+    Return if key doesn’t exist in the list.
+*/
+template <typename Key, typename Value, typename Compare>
+bool BasicSkipList<Key, Value, Compare>::remove(const Key &key){
+    // Nodes seen during the delete must not be freed until it completes
+    EpochGuard guard;
+
+    // References of the predecessors and successors, filled in by find
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+
+    bool removed = remove_from(key, preds, succs, load_finger(preds));
+    save_finger(preds);
+    return removed;
+}
+
+/**
+    Deletes the key using preds and succs for the traversal. If use_finger is set, preds holds the
+    predecessors of a smaller key and the traversal starts from them. Must be called inside an epoch.
+    Return if key doesn’t exist in the list.
+*/
+template <typename Key, typename Value, typename Compare>
+bool BasicSkipList<Key, Value, Compare>::remove_from(const Key &key, node_type **preds, node_type **succs, bool use_finger){
+    // Initialization
+    node_type* victim = NULL;
+    bool is_marked = false;
+    int top_level = -1;
+
+    Backoff backoff;
+
+    // Keep trying to delete the element from the list. In case predecessors and successors are changed,
+    // this loop helps to try the delete again
+    while(true){
+
+        // Find the predecessors and successors of where the key to be deleted
+        // A search from the finger covers the lowest levels only, search again up to the top of a taller node
+        int found = use_finger ? find_from(key, preds, succs, 0) : find(key, preds, succs);
+        if(use_finger && found != -1 && succs[found]->top_level > found){
+            found = find_from(key, preds, succs, succs[found]->top_level);
+        }
+
+        // If found, select the node to delete. else return
+        if(found != -1){
+            victim = succs[found];
+        }
+
+        // If node not found and the node to be deleted is fully linked and not marked return
+        if(is_marked |
+                (found != -1 &&
+                (victim->fully_linked && victim->top_level == found && !(victim->marked))
+                )
+            ){
+                // If not marked, the we lock the node and mark the node to delete
+                if(!is_marked){
+                    top_level = victim->top_level;
+                    victim->lock();
+                    if(victim->marked){
+                        victim->unlock();
+                        return false;
+                    }
+                    victim->marked = true;
+                    is_marked = true;
+                }
+
+                // Store all the Nodes which lock we acquire, at most one per level
+                // The same predecessor can appear at several consecutive levels, its lock is acquired only once
+                node_type* locked_nodes[MAX_LEVEL + 1];
+                int num_locked = 0;
+
+                // Traverse the skip list and try to acquire the lock of predecessor at every level
+                try{
+                    node_type* pred;
+
+                    // Used to check if the predecessors are not marked for delete and if the predecessor next is the node we are trying to delete or if it is changed.
+                    bool valid = true;
+
+                    for(int level = 0; valid && (level <= top_level); level++){
+                        pred = preds[level];
+
+                        // If not already acquired lock, then acquire the lock
+                        if(num_locked == 0 || locked_nodes[num_locked - 1] != pred){
+                            pred->lock();
+                            locked_nodes[num_locked++] = pred;
+                        }
+
+                        // If predecessor marked or if the predecessor's next has changed, then abort and try again
+                        valid = !(pred->marked) && pred->next[level] == victim;
+                    }
+
+                    // Conditons are not met, release locks, abort and try again.
+                    if(!valid){
+                        unlock_nodes(locked_nodes, num_locked);
+                        backoff.wait();
+                        continue;
+                    }
+
+                    // All conditions satisfied, delete the Node and link them to the successors appropriately
+                    for(int level = top_level; level >= 0; level--){
+                        preds[level]->next[level] = victim->next[level];
+                    }
+
+                    victim->unlock();
+
+                    // Delete is completed, release the locks held.
+                    unlock_nodes(locked_nodes, num_locked);
+
+                    // Concurrent readers may still be on the victim, so it is freed once they leave their epoch
+                    EpochManager::retire(victim, destroy_node);
+
+                    return true;
+                }catch(const std::exception& e){
+                    // If any exception occurs during the above delete, release locks of the held nodes and try again.
+                    unlock_nodes(locked_nodes, num_locked);
+                }
+
+            }else{
+                return false;
+            }
+    }
+}
+
+/**
+    Finds the predecessors and successors like find, starting from the nodes already in predecessors,
+    the finger, instead of the head. Finger nodes that are marked or not before key are not used.
+    The traversal starts at the lowest level from min_level up whose finger node is still the predecessor
+    of key, or at the top level, so a key close after the finger is reached in a few steps.
+    Below it, the traversal continues from the finger node if it is further than the node reached from the level above.
+    Only the levels up to the one the traversal starts at are updated.
+    Must be called inside an epoch.
+    Returns -1 if not the key does not exist, else the highest level searched the key was seen at.
+*/
+template <typename Key, typename Value, typename Compare>
+int BasicSkipList<Key, Value, Compare>::find_from(const Key &key, node_type **predecessors, node_type **successors, int min_level){
+    int found = -1;
+    node_type *prev = head;
+
+    int start = min_level;
+    while(start < max_level && !(predecessors[start] != head && !predecessors[start]->marked &&
+            before(predecessors[start], key) && !before(predecessors[start]->next[start], key))){
+        start++;
+    }
+
+    for (int level = start; level >= 0; level--){
+        node_type *finger = predecessors[level];
+        if(finger != head && !finger->marked && compare(finger->get_key(), key) &&
+                (prev == head || compare(prev->get_key(), finger->get_key()))){
+            prev = finger;
+        }
+
+        node_type *curr = prev->next[level];
+
+        while (before(curr, key)){
+            prev = curr;
+            curr = prev->next[level];
+        }
+
+        if(found == -1 && holds(curr, key)){
+            found = level;
+        }
+
+        predecessors[level] = prev;
+        successors[level] = curr;
+    }
+    return found;
+}
+
+/**
+    Links a run of new nodes, sorted and all falling between preds[0] and succs[0], under one acquisition
+    of the predecessor locks. Returns false without linking if the predecessors changed.
+*/
+template <typename Key, typename Value, typename Compare>
+bool BasicSkipList<Key, Value, Compare>::link_run(node_type **preds, node_type **succs, node_type **run, size_t run_length){
+    int top_level = 0;
+    for (size_t i = 0; i < run_length; i++){
+        if(run[i]->top_level > top_level){
+            top_level = run[i]->top_level;
+        }
+    }
+
+    node_type* locked_nodes[MAX_LEVEL + 1];
+    int num_locked = 0;
+    bool valid = true;
+
+    for (int level = 0; valid && (level <= top_level); level++){
+        node_type *pred = preds[level];
+        if(num_locked == 0 || locked_nodes[num_locked - 1] != pred){
+            pred->lock();
+            locked_nodes[num_locked++] = pred;
+        }
+        valid = !pred->marked && !succs[level]->marked && pred->next[level] == succs[level];
+    }
+
+    if(!valid){
+        unlock_nodes(locked_nodes, num_locked);
+        return false;
+    }
+
+    // Chain the run at every level first, then publish it from the predecessors
+    node_type *first[MAX_LEVEL + 1];
+    for (int level = 0; level <= top_level; level++){
+        node_type *last = NULL;
+        first[level] = NULL;
+        for (size_t i = 0; i < run_length; i++){
+            if(run[i]->top_level < level){
+                continue;
+            }
+            if(last == NULL){
+                first[level] = run[i];
+            }else{
+                last->next[level] = run[i];
+            }
+            last = run[i];
+        }
+        last->next[level] = succs[level];
+    }
+
+    for (int level = 0; level <= top_level; level++){
+        preds[level]->next[level] = first[level];
+    }
+
+    for (size_t i = 0; i < run_length; i++){
+        run[i]->fully_linked = true;
+    }
+
+    unlock_nodes(locked_nodes, num_locked);
+    return true;
+}
+
+/**
+    Inserts a batch of key value pairs. The batch is sorted and every key after the first is searched
+    from the predecessors of the previous one. Keys that fall between the same two nodes of the list are
+    linked together under one set of predecessor locks, up to BATCH_RUN_LIMIT at a time.
+    Keys that already exist and repeated keys after the first are not inserted.
+    Returns the number of keys inserted.
+*/
+template <typename Key, typename Value, typename Compare>
+size_t BasicSkipList<Key, Value, Compare>::add_batch(const vector<pair<Key, Value> > &batch){
+    // Sort references to the pairs, the keys and values are only copied into their nodes
+    const Compare &order = compare;
+    vector<const pair<Key, Value> *> sorted(batch.size());
+    for (size_t j = 0; j < batch.size(); j++){
+        sorted[j] = &batch[j];
+    }
+    stable_sort(sorted.begin(), sorted.end(), [&order](const pair<Key, Value> *a, const pair<Key, Value> *b){
+        return order(a->first, b->first);
+    });
+    sorted.erase(unique(sorted.begin(), sorted.end(), [&order](const pair<Key, Value> *a, const pair<Key, Value> *b){
+        return !order(a->first, b->first) && !order(b->first, a->first);
+    }), sorted.end());
+
+    EpochGuard guard;
+
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+    for (int level = 0; level <= max_level; level++){
+        preds[level] = head;
+    }
+
+    // Nodes are created once and kept across retries, the ones never linked are freed at the end
+    vector<node_type *> nodes(sorted.size(), NULL);
+    size_t inserted = 0;
+    size_t i = 0;
+    Backoff backoff;
+
+    while(i < sorted.size()){
+        int found = find_from(sorted[i]->first, preds, succs, max_level);
+
+        if(found != -1){
+            node_type* node_found = succs[found];
+            if(!node_found->marked){
+                Backoff linking;
+                while(! node_found->fully_linked){
+                    linking.wait();
+                }
+                i++;
+            }else{
+                backoff.wait();
+            }
+            continue;
+        }
+
+        // The run is every following key that still comes before the successor at level 0
+        size_t end = i + 1;
+        while(end < sorted.size() && end - i < BATCH_RUN_LIMIT && !before(succs[0], sorted[end]->first) && !holds(succs[0], sorted[end]->first)){
+            end++;
+        }
+
+        for (size_t j = i; j < end; j++){
+            if(nodes[j] == NULL){
+                nodes[j] = node_type::create(sorted[j]->first, sorted[j]->second, get_random_level());
+            }
+        }
+
+        if(!link_run(preds, succs, &nodes[i], end - i)){
+            backoff.wait();
+            continue;
+        }
+
+        // The last node of the run at each level precedes every later key of the batch
+        for (size_t j = i; j < end; j++){
+            for (int level = 0; level <= nodes[j]->top_level; level++){
+                preds[level] = nodes[j];
+            }
+        }
+
+        inserted += end - i;
+        i = end;
+    }
+
+    for (size_t j = 0; j < nodes.size(); j++){
+        if(nodes[j] != NULL && !nodes[j]->fully_linked){
+            node_type::destroy(nodes[j]);
+        }
+    }
+    return inserted;
+}
+
+/**
+    Deletes a batch of keys. The batch is sorted and every key after the first is searched
+    from the predecessors of the previous one.
+    Returns the number of keys deleted.
+*/
+template <typename Key, typename Value, typename Compare>
+size_t BasicSkipList<Key, Value, Compare>::remove_batch(vector<Key> batch){
+    const Compare &order = compare;
+    sort(batch.begin(), batch.end(), order);
+
+    EpochGuard guard;
+
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+    for (int level = 0; level <= max_level; level++){
+        preds[level] = head;
+    }
+
+    size_t removed = 0;
+    for (size_t i = 0; i < batch.size(); i++){
+        if(remove_from(batch[i], preds, succs, true)){
+            removed++;
+        }
+    }
+    return removed;
+}
+
+/**
+    Traverses the skip list from the top level down to the last node before key at every level.
+    Returns the node following it at level 0, the first node whose key is not before key.
+    Must be called inside an epoch.
+*/
+template <typename Key, typename Value, typename Compare>
+typename BasicSkipList<Key, Value, Compare>::node_type *BasicSkipList<Key, Value, Compare>::lower_bound(const Key &key){
+    node_type *pred = head;
+    node_type *curr = tail;
+
+    for (int level = max_level; level >= 0; level--){
+        curr = pred->next[level];
+        while (before(curr, key)){
+            pred = curr;
+            curr = pred->next[level];
+        }
+    }
+    // Reloading pred->next[0] could return a key inserted between pred and key meanwhile
+    return curr;
+}
+
+/**
+    Walks level 0 from the first key not before start_key and passes every key and value up to end_key
+    to visitor, without copying them. Marked nodes are skipped. Stops after limit pairs.
+    The references are only valid inside visitor.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+size_t BasicSkipList<Key, Value, Compare>::scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit){
+    if(compare(end_key, start_key)){
+        return 0;
+    }
+
+    EpochGuard guard;
+
+    size_t count = 0;
+    for (node_type *curr = lower_bound(start_key); count < limit && curr != tail && !compare(end_key, curr->get_key()); curr = curr->next[0]){
+        if(curr->fully_linked && !curr->marked){
+            visitor(curr->get_key(), curr->get_value());
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+    Passes every key and value of the list to visitor in key order, like scan without bounds.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, typename Compare>
+template <typename Function>
+size_t BasicSkipList<Key, Value, Compare>::scan_all(Function visitor){
+    EpochGuard guard;
+
+    size_t count = 0;
+    for (node_type *curr = head->next[0]; curr != tail; curr = curr->next[0]){
+        if(curr->fully_linked && !curr->marked){
+            visitor(curr->get_key(), curr->get_value());
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key in a map.
+    Use scan or Scan to read a range without copying it.
+*/
+template <typename Key, typename Value, typename Compare>
+map<Key, Value, Compare> BasicSkipList<Key, Value, Compare>::range(const Key &start_key, const Key &end_key){
+    map<Key, Value, Compare> range_output(compare);
+    scan(start_key, end_key, [&range_output](const Key &key, const Value &value){
+        range_output.insert(range_output.end(), make_pair(key, value));
+    });
+    return range_output;
+}
+
+/**
+    Walks level 0 from the head to the tail, one node after the other.
+    Returns the number of fully linked and unmarked nodes.
+*/
+template <typename Key, typename Value, typename Compare>
+size_t BasicSkipList<Key, Value, Compare>::size(){
+    EpochGuard guard;
+
+    size_t count = 0;
+    for (node_type *curr = head->next[0]; curr != tail; curr = curr->next[0]){
+        if(curr->fully_linked && !curr->marked){
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+    Display the skip list in readable format
+*/
+template <typename Key, typename Value, typename Compare>
+void BasicSkipList<Key, Value, Compare>::display(){
+    for (int i = 0; i <= max_level; i++) {
+        if(head->next[i] == tail){
+            break;
+        }
+        cout << "Level " << i << "  head -> ";
+        for (node_type *temp = head->next[i]; temp != tail; temp = temp->next[i]){
+            cout << temp->get_key() << " -> ";
+        }
+        cout << "tail" << endl;
+    }
+    printf("---------- Display done! ----------\n\n");
+}
+
+#endif
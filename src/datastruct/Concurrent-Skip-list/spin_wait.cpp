@@ -0,0 +1,54 @@
+/**
+    Slow paths of the word lock, parking on a futex
+*/
+
+#include "spin_wait.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+    Sleeps while the word still holds value. Returns at once if it changed, and may return spuriously.
+*/
+static void park(atomic<uint32_t> &word, uint32_t value){
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+    if(word.load(memory_order_relaxed) == value){
+        this_thread::yield();
+    }
+#endif
+}
+
+/**
+    Spins with backoff while the lock is held, then marks it as having a waiter and parks until it is released
+*/
+void WordLock::lock_contended(atomic<uint32_t> &word){
+    Backoff backoff;
+    while(backoff.spin()){
+        uint32_t expected = 0;
+        if(word.load(memory_order_relaxed) == 0 &&
+                word.compare_exchange_strong(expected, 1, memory_order_acquire, memory_order_relaxed)){
+            return;
+        }
+    }
+
+    // Taking the lock as 2 keeps the mark for the threads still parked behind this one
+    while(word.exchange(2, memory_order_acquire) != 0){
+        park(word, 2);
+    }
+}
+
+/**
+    Wakes one thread parked on the word
+*/
+void WordLock::wake(atomic<uint32_t> &word){
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    (void) word;
+#endif
+}
@@ -0,0 +1,93 @@
+#ifndef SPIN_WAIT_H
+#define SPIN_WAIT_H
+
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+    Tells the processor the thread is spinning, so the sibling hyperthread gets the core and leaving the loop
+    does not flush the pipeline
+*/
+static inline void cpu_relax(){
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+/**
+    Exponential backoff for a thread waiting on another one.
+    Every step spins twice as many pauses as the previous one, up to MAX_PAUSES, after which the thread yields
+    the processor instead, so a waiter never burns the time slice of the thread it waits for.
+*/
+class Backoff{
+    public:
+        // Pauses of the longest spinning step
+        static const unsigned MAX_PAUSES = 128;
+
+        Backoff() : pauses(1){
+        }
+
+        /**
+            Spins the next step, returns false without spinning once the spinning budget is used up
+        */
+        bool spin(){
+            if(pauses > MAX_PAUSES){
+                return false;
+            }
+            for (unsigned i = 0; i < pauses; i++){
+                cpu_relax();
+            }
+            pauses <<= 1;
+            return true;
+        }
+
+        /**
+            Spins the next step, or yields once the spinning budget is used up
+        */
+        void wait(){
+            if(!spin()){
+                this_thread::yield();
+            }
+        }
+
+    private:
+        unsigned pauses;
+};
+
+/**
+    Lock on a 32 bit word: 0 when free, 1 when held, 2 when held and a thread may be parked on it.
+    A thread that finds the lock held spins with backoff for a bounded time, then parks in the kernel
+    on a futex until the holder wakes it. An uncontended lock and unlock each take one atomic instruction.
+*/
+class WordLock{
+    public:
+        static void lock(atomic<uint32_t> &word){
+            uint32_t expected = 0;
+            if(!word.compare_exchange_strong(expected, 1, memory_order_acquire, memory_order_relaxed)){
+                lock_contended(word);
+            }
+        }
+
+        static void unlock(atomic<uint32_t> &word){
+            if(word.exchange(0, memory_order_release) == 2){
+                wake(word);
+            }
+        }
+
+    private:
+        static void lock_contended(atomic<uint32_t> &word);
+        static void wake(atomic<uint32_t> &word);
+};
+
+#endif
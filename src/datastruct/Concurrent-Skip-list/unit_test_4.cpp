@@ -0,0 +1,182 @@
+/**
+	Unit test 4 for the concurrent unrolled skip list, with 4 keys per node so that splits and merges happen
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unrolled_skip_list.h"
+
+using namespace std;
+
+size_t num_threads = 8;
+int max_number = 20000;
+UnrolledSkipList<int, string, 4> *skiplist;
+
+// Wrong results seen by the threads, checked after they are joined
+atomic<int> errors(0);
+atomic<bool> churning(false);
+
+/**
+    Adds the keys of the thread and removes every third one right after adding it.
+    The thread owns its keys, so it knows what contains must return for them.
+*/
+void skiplist_add_remove(size_t id){
+    for(int key = 1 + id; key <= max_number; key += num_threads){
+        if(!skiplist->add(key, to_string(key)) || !skiplist->contains(key)){
+            errors++;
+        }
+        if(key % 3 == 0){
+            if(!skiplist->remove(key) || skiplist->contains(key)){
+                errors++;
+            }
+        }
+    }
+}
+
+/**
+    Removes the keys of the thread with key % 3 == 1, which empties most nodes and merges them
+*/
+void skiplist_remove(size_t id){
+    for(int key = 1 + id; key <= max_number; key += num_threads){
+        if(key % 3 == 1 && !skiplist->remove(key)){
+            errors++;
+        }
+    }
+}
+
+/**
+    Scans random ranges while other threads change the list, every key must be inside the range and in order
+*/
+void skiplist_scan(unsigned int seed){
+    while(churning){
+        int start = 1 + rand_r(&seed) % max_number;
+        int end = start + rand_r(&seed) % 500;
+        int last = start - 1;
+        skiplist->scan(start, end, [&](const int &key, const string &value){
+            if(key <= last || key > end || value != to_string(key)){
+                errors++;
+            }
+            last = key;
+        });
+    }
+}
+
+/**
+    Returns true if the list holds exactly the keys from 1 to max_number for which expected is true
+*/
+template <typename Predicate>
+bool check_contents(Predicate expected){
+    size_t count = 0;
+    bool matches = true;
+    for(int key = 1; key <= max_number; key++){
+        if(skiplist->contains(key) != expected(key)){
+            matches = false;
+        }
+        if(expected(key)){
+            count++;
+        }
+    }
+    if(skiplist->size() != count){
+        matches = false;
+    }
+
+    map<int, string> range_output = skiplist->range(1, max_number);
+    if(range_output.size() != count){
+        matches = false;
+    }
+    for(auto const &entry : range_output){
+        if(!expected(entry.first) || entry.second != to_string(entry.first)){
+            matches = false;
+        }
+    }
+
+    // A range inside the list, both ends included
+    map<int, string> middle = skiplist->range(max_number / 3, 2 * max_number / 3);
+    size_t middle_count = 0;
+    for(int key = max_number / 3; key <= 2 * max_number / 3; key++){
+        if(expected(key)){
+            middle_count++;
+        }
+    }
+    if(middle.size() != middle_count || (!middle.empty() && (middle.begin()->first < max_number / 3 || middle.rbegin()->first > 2 * max_number / 3))){
+        matches = false;
+    }
+    return matches;
+}
+
+/**
+    Performs concurrent adds and removes on an unrolled skip list and checks its contents
+*/
+int main(int argc, char *argv[]){
+
+    cout << "\n---------- Unit Test - 4 ----------" << endl;
+
+    cout << "\nThis Unit test uses 8 Threads on an unrolled skip list with 4 keys per node. Numbers (1-20000) are inserted" << endl;
+    cout << "parallelly and every third one is removed right after. Then the numbers with remainder 1 by 3 are removed" << endl;
+    cout << "parallelly while other threads scan ranges. The contents are checked with contains, size and range." << endl;
+    cout << "This is an automated test, and only the test results are displayed. " << endl;
+
+    skiplist = new UnrolledSkipList<int, string, 4>(max_number, 0.5);
+
+    vector<thread> threads;
+
+    // insert and delete, splitting nodes
+    for(size_t i = 0; i < num_threads; i++){
+        threads.push_back(thread(skiplist_add_remove, i));
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+    threads.clear();
+
+    if(errors == 0){
+        cout << "Unit Test 1: Insert and Delete: PASS" << endl;
+    }else{
+        cout << "Unit Test 1: Insert and Delete: FAIL" << endl;
+    }
+
+    if(check_contents([](int key){ return key % 3 != 0; })){
+        cout << "Unit Test 2: Contains, Size and Range: PASS" << endl;
+    }else{
+        cout << "Unit Test 2: Contains, Size and Range: FAIL" << endl;
+    }
+
+    // delete while scanning, merging nodes
+    churning = true;
+    for(size_t i = 0; i < num_threads / 2; i++){
+        threads.push_back(thread(skiplist_scan, (unsigned int) i + 1));
+    }
+    vector<thread> removers;
+    for(size_t i = 0; i < num_threads; i++){
+        removers.push_back(thread(skiplist_remove, i));
+    }
+    for (auto &th : removers) {
+        th.join();
+    }
+    churning = false;
+    for (auto &th : threads) {
+        th.join();
+    }
+    threads.clear();
+
+    if(errors == 0){
+        cout << "Unit Test 3: Delete and Scan: PASS" << endl;
+    }else{
+        cout << "Unit Test 3: Delete and Scan: FAIL" << endl;
+    }
+
+    if(check_contents([](int key){ return key % 3 == 2; })){
+        cout << "Unit Test 4: Contains, Size and Range: PASS" << endl;
+    }else{
+        cout << "Unit Test 4: Contains, Size and Range: FAIL" << endl;
+    }
+
+    delete skiplist;
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+/**
+	Unit test 5 for the sharded skip list, with a small split size so that shards are split online
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sharded_skip_list.h"
+
+using namespace std;
+
+size_t num_threads = 8;
+int max_number = 20000;
+ShardedSkipList<int, string> *skiplist;
+
+// Wrong results seen by the threads, checked after they are joined
+atomic<int> errors(0);
+atomic<bool> churning(false);
+
+/**
+    Adds the keys of the thread and removes every third one right after adding it.
+    The thread owns its keys, so it knows what contains must return for them.
+*/
+void skiplist_add_remove(size_t id){
+    for(int key = 1 + id; key <= max_number; key += num_threads){
+        if(!skiplist->add(key, to_string(key)) || !skiplist->contains(key)){
+            errors++;
+        }
+        if(key % 3 == 0){
+            if(!skiplist->remove(key) || skiplist->contains(key)){
+                errors++;
+            }
+        }
+    }
+}
+
+/**
+    Scans random ranges while shards are split, every key must be inside the range and in order
+*/
+void skiplist_scan(unsigned int seed){
+    while(churning){
+        int start = 1 + rand_r(&seed) % max_number;
+        int end = start + rand_r(&seed) % 2000;
+        int last = start - 1;
+        skiplist->scan(start, end, [&](const int &key, const string &value){
+            if(key <= last || key > end || value != to_string(key)){
+                errors++;
+            }
+            last = key;
+        });
+    }
+}
+
+/**
+    Returns true if range(start, end) holds exactly the keys not divisible by 3 between start and end
+*/
+bool check_range(int start, int end){
+    map<int, string> range_output = skiplist->range(start, end);
+    map<int, string>::iterator it = range_output.begin();
+    for(int key = start; key <= end; key++){
+        if(key % 3 == 0){
+            continue;
+        }
+        if(it == range_output.end() || it->first != key || it->second != to_string(key)){
+            return false;
+        }
+        ++it;
+    }
+    return it == range_output.end();
+}
+
+/**
+    Performs concurrent adds and removes on a sharded skip list that splits its shards, and checks its contents
+*/
+int main(int argc, char *argv[]){
+
+    cout << "\n---------- Unit Test - 5 ----------" << endl;
+
+    cout << "\nThis Unit test uses 8 Threads on a sharded skip list that starts with one shard and splits shards holding" << endl;
+    cout << "more than 256 keys. Numbers (1-20000) are inserted parallelly and every third one is removed right after," << endl;
+    cout << "while other threads scan ranges. The shard count, size and ranges across every split are then checked." << endl;
+    cout << "This is an automated test, and only the test results are displayed. " << endl;
+
+    skiplist = new ShardedSkipList<int, string>(vector<int>(), max_number, 0.5, 256);
+
+    vector<thread> threads;
+
+    // insert and delete while scanning, splitting shards
+    churning = true;
+    for(size_t i = 0; i < num_threads / 2; i++){
+        threads.push_back(thread(skiplist_scan, (unsigned int) i + 1));
+    }
+    vector<thread> writers;
+    for(size_t i = 0; i < num_threads; i++){
+        writers.push_back(thread(skiplist_add_remove, i));
+    }
+    for (auto &th : writers) {
+        th.join();
+    }
+    churning = false;
+    for (auto &th : threads) {
+        th.join();
+    }
+    threads.clear();
+
+    if(errors == 0){
+        cout << "Unit Test 1: Insert, Delete and Scan: PASS" << endl;
+    }else{
+        cout << "Unit Test 1: Insert, Delete and Scan: FAIL" << endl;
+    }
+
+    if(skiplist->shard_count() > 1){
+        cout << "Unit Test 2: Split: PASS" << endl;
+    }else{
+        cout << "Unit Test 2: Split: FAIL" << endl;
+    }
+
+    size_t expected = 0;
+    bool contains_matches = true;
+    for(int key = 1; key <= max_number; key++){
+        if(key % 3 != 0){
+            expected++;
+        }
+        if(skiplist->contains(key) != (key % 3 != 0)){
+            contains_matches = false;
+        }
+    }
+    if(contains_matches && skiplist->size() == expected){
+        cout << "Unit Test 3: Contains and Size: PASS" << endl;
+    }else{
+        cout << "Unit Test 3: Contains and Size: FAIL" << endl;
+    }
+
+    // Overlapping windows cover every split point, so some window crosses each one
+    bool ranges_match = check_range(1, max_number);
+    for(int start = 1; start <= max_number; start += 50){
+        if(!check_range(start, min(start + 100, max_number))){
+            ranges_match = false;
+        }
+    }
+    if(ranges_match){
+        cout << "Unit Test 4: Range: PASS" << endl;
+    }else{
+        cout << "Unit Test 4: Range: FAIL" << endl;
+    }
+
+    delete skiplist;
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+	Unit test 6 for the multi version skip list, reads through a snapshot must not change while writers continue
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mvcc_skip_list.h"
+
+using namespace std;
+
+size_t num_threads = 8;
+int max_number = 10000;
+int rounds = 20;
+MvccSkipList<int, string> *skiplist;
+
+// Wrong results seen by the threads, checked after they are joined
+atomic<int> errors(0);
+atomic<bool> churning(false);
+
+/**
+    Adds the keys of the thread, with the value seen by the snapshot
+*/
+void skiplist_add(size_t id){
+    for(int key = 1 + id; key <= max_number; key += num_threads){
+        if(!skiplist->add(key, to_string(key))){
+            errors++;
+        }
+    }
+}
+
+/**
+    Keeps updating the keys of the thread: every round puts a new value, removes every third key and adds it back,
+    and adds keys above max_number that the snapshot must not see. The versions are trimmed every few updates of a key.
+*/
+void skiplist_update(size_t id){
+    for(int round = 1; round <= rounds; round++){
+        for(int key = 1 + id; key <= max_number; key += num_threads){
+            skiplist->put(key, to_string(round) + "-" + to_string(key));
+            if(key % 3 == 0){
+                if(!skiplist->remove(key)){
+                    errors++;
+                }
+                if(round < rounds && !skiplist->add(key, to_string(round) + "-" + to_string(key))){
+                    errors++;
+                }
+            }
+        }
+        skiplist->add(max_number + round * (int) num_threads + (int) id, "new");
+    }
+}
+
+/**
+    Reads through the snapshot while the writers run, it must keep returning the keys and values it was taken with
+*/
+void skiplist_snapshot_read(MvccSkipList<int, string>::Snapshot *snapshot, const map<int, string> *expected,
+        unsigned int seed){
+    while(churning){
+        int key = 1 + rand_r(&seed) % max_number;
+        string value;
+        if(!skiplist->search(key, *snapshot, value) || value != to_string(key)){
+            errors++;
+        }
+        int start = 1 + rand_r(&seed) % max_number;
+        int end = start + rand_r(&seed) % 500;
+        map<int, string> range_output = skiplist->range(start, end, *snapshot);
+        if(range_output != map<int, string>(expected->lower_bound(start), expected->upper_bound(end))){
+            errors++;
+        }
+    }
+}
+
+/**
+    Takes a snapshot of a skip list, keeps updating it concurrently and checks that reads through the snapshot are unchanged
+*/
+int main(int argc, char *argv[]){
+
+    cout << "\n---------- Unit Test - 6 ----------" << endl;
+
+    cout << "\nThis Unit test uses 8 Threads on a multi version skip list. Numbers (1-10000) are inserted parallelly and" << endl;
+    cout << "a snapshot is taken. Then the values are replaced, every third number is removed and added back, and new" << endl;
+    cout << "numbers are inserted parallelly while other threads read through the snapshot, which must not change." << endl;
+    cout << "This is an automated test, and only the test results are displayed. " << endl;
+
+    skiplist = new MvccSkipList<int, string>(max_number, 0.5);
+
+    vector<thread> threads;
+
+    for(size_t i = 0; i < num_threads; i++){
+        threads.push_back(thread(skiplist_add, i));
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+    threads.clear();
+
+    MvccSkipList<int, string>::Snapshot *snapshot = new MvccSkipList<int, string>::Snapshot(*skiplist);
+    map<int, string> before = skiplist->range(1, max_number, *snapshot);
+
+    if(errors == 0 && before.size() == (size_t) max_number){
+        cout << "Unit Test 1: Insert and Snapshot Range: PASS" << endl;
+    }else{
+        cout << "Unit Test 1: Insert and Snapshot Range: FAIL" << endl;
+    }
+
+    // update while reading through the snapshot
+    churning = true;
+    for(size_t i = 0; i < num_threads / 2; i++){
+        threads.push_back(thread(skiplist_snapshot_read, snapshot, &before, (unsigned int) i + 1));
+    }
+    vector<thread> writers;
+    for(size_t i = 0; i < num_threads; i++){
+        writers.push_back(thread(skiplist_update, i));
+    }
+    for (auto &th : writers) {
+        th.join();
+    }
+    churning = false;
+    for (auto &th : threads) {
+        th.join();
+    }
+    threads.clear();
+
+    if(errors == 0){
+        cout << "Unit Test 2: Update and Snapshot Read: PASS" << endl;
+    }else{
+        cout << "Unit Test 2: Update and Snapshot Read: FAIL" << endl;
+    }
+
+    // The snapshot range is unchanged, and does not see the keys added after it
+    if(skiplist->range(1, 2 * max_number, *snapshot) == before){
+        cout << "Unit Test 3: Snapshot Range: PASS" << endl;
+    }else{
+        cout << "Unit Test 3: Snapshot Range: FAIL" << endl;
+    }
+
+    // Keys removed after the snapshot are still found through it, with the value they had
+    bool removed_found = true;
+    for(int key = 3; key <= max_number; key += 3){
+        string value;
+        if(skiplist->contains(key) || !skiplist->search(key, *snapshot, value) || value != to_string(key)){
+            removed_found = false;
+        }
+    }
+    if(removed_found){
+        cout << "Unit Test 4: Snapshot Search of Removed Keys: PASS" << endl;
+    }else{
+        cout << "Unit Test 4: Snapshot Search of Removed Keys: FAIL" << endl;
+    }
+
+    delete snapshot;
+
+    // The latest state holds the values of the last round
+    bool latest_matches = true;
+    map<int, string> latest = skiplist->range(1, max_number);
+    for(int key = 1; key <= max_number; key++){
+        if(key % 3 == 0){
+            continue;
+        }
+        if(latest[key] != to_string(rounds) + "-" + to_string(key)){
+            latest_matches = false;
+        }
+    }
+    if(latest_matches && latest.size() == (size_t) (max_number - max_number / 3)){
+        cout << "Unit Test 5: Latest Range: PASS" << endl;
+    }else{
+        cout << "Unit Test 5: Latest Range: FAIL" << endl;
+    }
+
+    delete skiplist;
+
+    return 0;
+}
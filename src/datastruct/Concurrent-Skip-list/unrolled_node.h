@@ -0,0 +1,151 @@
+#ifndef UNROLLED_NODE_H
+#define UNROLLED_NODE_H
+
+#include <new>
+#include <atomic>
+#include <stdint.h>
+#include "node_allocator.h"
+#include "spin_wait.h"
+
+using namespace std;
+
+/**
+    One node of the unrolled skip list, holding up to K sorted keys in a single block sized to its top level.
+    The node covers the keys from its anchor up to the anchor of the next node at level 0.
+    Keys are stored in an array of their own so a search inside the node reads consecutive keys,
+    values are stored by reference and never change once stored, so a reader can use them after validating.
+    Writers hold the lock, and make the version odd while they change the entries or the level 0 link,
+    readers copy what they need and retry if the version changed meanwhile.
+*/
+template <typename Key, typename Value, size_t K>
+class UnrolledNode{
+    public:
+        // The Maximum level until which the node is available
+        int top_level;
+
+        // Lock word to lock the node when modifing it, see WordLock
+        atomic<uint32_t> lock_word;
+
+        // Even while the entries are stable, odd while a writer changes them
+        atomic<uint32_t> version;
+
+        // Set once the node has been merged into its predecessor, under an odd version
+        atomic<bool> marked;
+
+        // Number of entries in use
+        atomic<uint32_t> count;
+
+        // Smallest key the node can hold, fixed for the lifetime of the node
+        Key anchor;
+
+        // Sorted keys and their values, the first count entries are in use
+        Key keys[K];
+        Value *values[K];
+
+        // Stores the reference of the next node until the top level for the node
+        UnrolledNode *next[];
+
+        static UnrolledNode *create(const Key &anchor, int level);
+        static void destroy(UnrolledNode *node);
+
+        void lock();
+        void unlock();
+
+        /**
+            Waits until no writer is changing the node and returns the version to validate against
+        */
+        uint32_t read_begin() const{
+            Backoff backoff;
+            while(true){
+                uint32_t current = version.load(memory_order_acquire);
+                if((current & 1) == 0){
+                    return current;
+                }
+                backoff.wait();
+            }
+        }
+
+        /**
+            Returns true if nothing changed in the node since read_begin returned version
+        */
+        bool read_validate(uint32_t current) const{
+            atomic_thread_fence(memory_order_acquire);
+            return version.load(memory_order_relaxed) == current;
+        }
+
+        /**
+            Starts and ends a change of the entries or the level 0 link. The lock must be held.
+        */
+        void write_begin(){
+            version.store(version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_release);
+        }
+        void write_end(){
+            version.store(version.load(memory_order_relaxed) + 1, memory_order_release);
+        }
+
+    private:
+        UnrolledNode(const Key &anchor, int level);
+        UnrolledNode(const UnrolledNode &);
+        UnrolledNode &operator=(const UnrolledNode &);
+
+        static size_t block_size(int level){
+            return sizeof(UnrolledNode) + (level + 1) * sizeof(UnrolledNode *);
+        }
+};
+
+/**
+    Allocates an empty node with room for level + 1 next references in the same block
+*/
+template <typename Key, typename Value, size_t K>
+UnrolledNode<Key, Value, K> *UnrolledNode<Key, Value, K>::create(const Key &anchor, int level){
+    void *memory = NodeAllocator::allocate(block_size(level));
+    try{
+        return new (memory) UnrolledNode(anchor, level);
+    }catch(...){
+        NodeAllocator::deallocate(memory, block_size(level));
+        throw;
+    }
+}
+
+/**
+    Frees a node allocated with create. The values it references are not freed.
+*/
+template <typename Key, typename Value, size_t K>
+void UnrolledNode<Key, Value, K>::destroy(UnrolledNode *node){
+    if(node == NULL){
+        return;
+    }
+    int level = node->top_level;
+    node->~UnrolledNode();
+    NodeAllocator::deallocate(node, block_size(level));
+}
+
+/**
+    Constructor
+*/
+template <typename Key, typename Value, size_t K>
+UnrolledNode<Key, Value, K>::UnrolledNode(const Key &anchor, int level) : top_level(level), lock_word(0), version(0),
+        marked(false), count(0), anchor(anchor){
+    for (int i = 0; i <= level; i++){
+        next[i] = NULL;
+    }
+}
+
+/**
+    Locks the node. Spins with backoff while it is held, then parks until the holder releases it.
+*/
+template <typename Key, typename Value, size_t K>
+void UnrolledNode<Key, Value, K>::lock(){
+    WordLock::lock(lock_word);
+}
+
+/**
+    Unlocks the node and wakes a parked waiter
+*/
+template <typename Key, typename Value, size_t K>
+void UnrolledNode<Key, Value, K>::unlock(){
+    WordLock::unlock(lock_word);
+}
+
+#endif
@@ -0,0 +1,709 @@
+#ifndef UNROLLED_SKIP_LIST_H
+#define UNROLLED_SKIP_LIST_H
+
+/**
+    Implements the Concurrent Unrolled Skip list, a skip list whose nodes hold up to K keys each
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <type_traits>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "unrolled_node.h"
+#include "key_search.h"
+#include "epoch.h"
+#include "level_generator.h"
+
+/**
+    Skip list ordered by Compare on Key, storing up to K keys and their values in every node.
+    The towers link the nodes by their anchors, a node holds the keys from its anchor up to the anchor of the next node.
+    The head is a node too, it holds the smallest keys and has no anchor. The tail is a sentinel recognized by its address.
+
+    Searches and scans read a node without locking it and retry if its version changed meanwhile.
+    An insert into a full node splits it, moving its upper half into a new node linked right after it.
+    A remove that leaves a node at most a quarter full merges it into its predecessor if the two fit in one node.
+    Keys are read while writers may change them, so Key must be trivially copyable.
+
+    The operations are those of BasicSkipList except Scan and set_finger. Splits and merges move keys and
+    values between nodes, so an iterator holding references into a node cannot stay valid, use scan instead.
+*/
+template <typename Key, typename Value, size_t K, typename Compare = less<Key> >
+class UnrolledSkipList{
+    static_assert(K >= 2, "an unrolled node must hold at least two keys");
+    static_assert(is_trivially_copyable<Key>::value, "keys are read optimistically and must be trivially copyable");
+
+    public:
+        typedef UnrolledNode<Key, Value, K> node_type;
+
+        // Upper bound of max_level, sizes the predecessor and successor arrays
+        static const int MAX_LEVEL = 32;
+
+        // A node left with at most this many keys is merged into its predecessor if they fit in one node
+        static const size_t MERGE_THRESHOLD = K / 4;
+
+    private:
+        // Head and Tail of the Skiplist
+        node_type *head;
+        node_type *tail;
+
+        // Highest level a node can have in this list
+        int max_level;
+
+        // Draws the levels of new nodes with the probability of the list
+        LevelGenerator levels;
+
+        // Orders the keys
+        Compare compare;
+
+        void locate(const Key &key, node_type **predecessors, node_type **successors, bool inclusive);
+        node_type *lock_owner(const Key &key, node_type **preds, node_type **succs);
+        node_type *split(node_type *node, node_type **preds, node_type **succs);
+        bool merge(node_type *node, node_type **preds, node_type **succs);
+        bool read(const Key &key, Value *&value);
+        template <typename Function>
+        size_t walk(const Key *start_key, const Key *end_key, Function visitor, size_t limit);
+
+        /**
+            Returns true if the node starts before key, or at key when inclusive is set.
+            The head starts before every key and the tail after every key.
+        */
+        bool starts_before(node_type *node, const Key &key, bool inclusive){
+            if(node == head){
+                return true;
+            }
+            if(node == tail){
+                return false;
+            }
+            return inclusive ? !compare(key, node->anchor) : compare(node->anchor, key);
+        }
+
+        /**
+            Returns the first of the count keys of the node that is not before key, or count.
+            Integer keys in ascending order are compared a vector at a time.
+        */
+        size_t position(const node_type *node, size_t count, const Key &key){
+            return NodeSearch<Key, Compare>::lower_bound(node->keys, count, key, compare);
+        }
+
+        static void destroy_node(void *node){
+            node_type::destroy(static_cast<node_type *>(node));
+        }
+
+        static void unlock_nodes(node_type **nodes, int count){
+            for (int i = 0; i < count; i++){
+                nodes[i]->unlock();
+            }
+        }
+
+    public:
+        UnrolledSkipList(int max_elements, float probability, const Compare &compare = Compare());
+        ~UnrolledSkipList();
+        int get_random_level();
+
+        // Supported operations
+        bool add(const Key &key, const Value &value);
+        Value search(const Key &key);
+        bool contains(const Key &key);
+        template <typename Function>
+        bool search(const Key &key, Function on_found);
+        bool remove(const Key &key);
+        size_t add_batch(const vector<pair<Key, Value> > &batch);
+        size_t remove_batch(vector<Key> batch);
+        map<Key, Value, Compare> range(const Key &start_key, const Key &end_key);
+        template <typename Function>
+        size_t scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit = numeric_limits<size_t>::max());
+        template <typename Function>
+        size_t scan_all(Function visitor);
+        size_t size();
+        void display();
+
+    private:
+        UnrolledSkipList(const UnrolledSkipList &);
+        UnrolledSkipList &operator=(const UnrolledSkipList &);
+};
+
+/**
+    Constructor. The levels are sized for max_elements keys spread over nodes about half full.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+UnrolledSkipList<Key, Value, K, Compare>::UnrolledSkipList(int max_elements, float prob, const Compare &compare) : compare(compare){
+    int max_nodes = max_elements / (int)(K / 2);
+    if (max_nodes < 2) max_nodes = 2;
+    max_level = (int) round(log(max_nodes) / log(1/prob)) - 1;
+    if (max_level < 0) max_level = 0;
+    if (max_level > MAX_LEVEL) max_level = MAX_LEVEL;
+    levels = LevelGenerator(max_level, prob);
+
+    head = node_type::create(Key(), max_level);
+    tail = node_type::create(Key(), max_level);
+
+    for (int i = 0; i <= max_level; i++) {
+        head->next[i] = tail;
+    }
+}
+
+/**
+    Destructor. Frees the nodes still linked at level 0 and their values, merged nodes belong to the epoch reclaimer.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+UnrolledSkipList<Key, Value, K, Compare>::~UnrolledSkipList(){
+    for (node_type *node = head; node != tail; ){
+        node_type *next = node->next[0];
+        for (size_t i = 0; i < node->count; i++){
+            delete node->values[i];
+        }
+        node_type::destroy(node);
+        node = next;
+    }
+    node_type::destroy(tail);
+}
+
+/**
+    Draws the top level of a new node, each level is reached with the probability given to the constructor.
+    This decides until which level a new node is available.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+int UnrolledSkipList<Key, Value, K, Compare>::get_random_level(){
+    return levels.next();
+}
+
+/**
+    Finds at each level the last node that starts before key, or at key when inclusive is set, and the node after it.
+    Must be called inside an epoch.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+void UnrolledSkipList<Key, Value, K, Compare>::locate(const Key &key, node_type **predecessors, node_type **successors, bool inclusive){
+    node_type *prev = head;
+
+    for (int level = max_level; level >= 0; level--){
+        node_type *curr = prev->next[level];
+
+        while (starts_before(curr, key, inclusive)){
+            prev = curr;
+            curr = prev->next[level];
+        }
+
+        predecessors[level] = prev;
+        successors[level] = curr;
+    }
+}
+
+/**
+    Locks and returns the node whose range holds key, found with locate.
+    The node is unmarked and its next node at level 0 starts after key while the lock is held.
+    Must be called inside an epoch.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+typename UnrolledSkipList<Key, Value, K, Compare>::node_type *UnrolledSkipList<Key, Value, K, Compare>::lock_owner(const Key &key, node_type **preds, node_type **succs){
+    while(true){
+        locate(key, preds, succs, true);
+        node_type *node = preds[0];
+
+        node->lock();
+        if(!node->marked && !starts_before(node->next[0], key, true)){
+            return node;
+        }
+        node->unlock();
+    }
+}
+
+/**
+    Moves the upper half of a full, locked node into a new node linked right after it at every level of the new node.
+    Returns the new node, locked. preds and succs are overwritten.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+typename UnrolledSkipList<Key, Value, K, Compare>::node_type *UnrolledSkipList<Key, Value, K, Compare>::split(node_type *node, node_type **preds, node_type **succs){
+    const size_t half = K / 2;
+
+    // The new node is filled and locked before anyone can reach it
+    node_type *sibling = node_type::create(node->keys[half], get_random_level());
+    sibling->lock();
+    for (size_t i = half; i < K; i++){
+        sibling->keys[i - half] = node->keys[i];
+        sibling->values[i - half] = node->values[i];
+    }
+    sibling->count.store(K - half, memory_order_relaxed);
+
+    // Lock the predecessors of the new node above level 0, they come before node in the list
+    node_type* locked_nodes[MAX_LEVEL + 1];
+    int num_locked;
+    while(true){
+        locate(sibling->anchor, preds, succs, false);
+
+        // A traversal through a node merged meanwhile can miss node, try again
+        if(preds[0] != node){
+            continue;
+        }
+
+        num_locked = 0;
+        bool valid = true;
+        for (int level = 1; valid && level <= sibling->top_level; level++){
+            node_type *pred = preds[level];
+            if(pred != node && (num_locked == 0 || locked_nodes[num_locked - 1] != pred)){
+                pred->lock();
+                locked_nodes[num_locked++] = pred;
+            }
+            valid = !pred->marked && !succs[level]->marked && pred->next[level] == succs[level];
+        }
+
+        if(valid){
+            break;
+        }
+        unlock_nodes(locked_nodes, num_locked);
+    }
+
+    for (int level = 0; level <= sibling->top_level; level++){
+        sibling->next[level] = succs[level];
+    }
+
+    // Readers of node see the keys it gave away and the link to the new node change together
+    node->write_begin();
+    node->count.store(half, memory_order_relaxed);
+    for (int level = 0; level <= sibling->top_level; level++){
+        preds[level]->next[level] = sibling;
+    }
+    node->write_end();
+
+    unlock_nodes(locked_nodes, num_locked);
+    return sibling;
+}
+
+/**
+    Merges a locked node into its predecessor at level 0 if their keys fit in one node, and unlinks it.
+    The node stays locked, once merged it is marked and must be retired. preds and succs are overwritten.
+    Returns true if the node was merged.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+bool UnrolledSkipList<Key, Value, K, Compare>::merge(node_type *node, node_type **preds, node_type **succs){
+    node_type* locked_nodes[MAX_LEVEL + 1];
+    int num_locked;
+    while(true){
+        locate(node->anchor, preds, succs, false);
+
+        num_locked = 0;
+        bool valid = true;
+        for (int level = 0; valid && level <= node->top_level; level++){
+            node_type *pred = preds[level];
+            if(num_locked == 0 || locked_nodes[num_locked - 1] != pred){
+                pred->lock();
+                locked_nodes[num_locked++] = pred;
+            }
+            valid = !pred->marked && pred->next[level] == node;
+        }
+
+        if(valid){
+            break;
+        }
+        unlock_nodes(locked_nodes, num_locked);
+    }
+
+    node_type *pred = preds[0];
+    size_t pred_count = pred->count.load(memory_order_relaxed);
+    size_t count = node->count.load(memory_order_relaxed);
+    if(pred_count + count > K){
+        unlock_nodes(locked_nodes, num_locked);
+        return false;
+    }
+
+    // Every key of node comes after the keys of its predecessor
+    pred->write_begin();
+    node->write_begin();
+    for (size_t i = 0; i < count; i++){
+        pred->keys[pred_count + i] = node->keys[i];
+        pred->values[pred_count + i] = node->values[i];
+    }
+    pred->count.store(pred_count + count, memory_order_relaxed);
+    node->marked = true;
+    for (int level = node->top_level; level >= 0; level--){
+        preds[level]->next[level] = node->next[level];
+    }
+    node->write_end();
+    pred->write_end();
+
+    unlock_nodes(locked_nodes, num_locked);
+    return true;
+}
+
+/**
+    Inserts into the node holding the range of key, splitting it first if it is full.
+    Return if already exists.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+bool UnrolledSkipList<Key, Value, K, Compare>::add(const Key &key, const Value &value){
+    // Nodes seen during the insert must not be freed until it completes
+    EpochGuard guard;
+
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+
+    node_type *node = lock_owner(key, preds, succs);
+    size_t count = node->count.load(memory_order_relaxed);
+    size_t slot = position(node, count, key);
+    if(slot < count && !compare(key, node->keys[slot])){
+        node->unlock();
+        return false;
+    }
+
+    Value *stored = new Value(value);
+
+    // A key after the first one moved to the new node belongs to the new node
+    node_type *sibling = NULL;
+    node_type *target = node;
+    if(count == K){
+        sibling = split(node, preds, succs);
+        if(slot > K / 2){
+            target = sibling;
+            slot -= K / 2;
+        }
+        count = target->count.load(memory_order_relaxed);
+    }
+
+    target->write_begin();
+    for (size_t i = count; i > slot; i--){
+        target->keys[i] = target->keys[i - 1];
+        target->values[i] = target->values[i - 1];
+    }
+    target->keys[slot] = key;
+    target->values[slot] = stored;
+    target->count.store(count + 1, memory_order_relaxed);
+    target->write_end();
+
+    if(sibling != NULL){
+        sibling->unlock();
+    }
+    node->unlock();
+    return true;
+}
+
+/**
+    Deletes the key from the node holding its range, merging the node into its predecessor if it gets sparse.
+    Return if key doesn’t exist in the list.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+bool UnrolledSkipList<Key, Value, K, Compare>::remove(const Key &key){
+    // Nodes seen during the delete must not be freed until it completes
+    EpochGuard guard;
+
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+
+    node_type *node = lock_owner(key, preds, succs);
+    size_t count = node->count.load(memory_order_relaxed);
+    size_t slot = position(node, count, key);
+    if(slot == count || compare(key, node->keys[slot])){
+        node->unlock();
+        return false;
+    }
+
+    Value *removed = node->values[slot];
+
+    node->write_begin();
+    for (size_t i = slot + 1; i < count; i++){
+        node->keys[i - 1] = node->keys[i];
+        node->values[i - 1] = node->values[i];
+    }
+    node->count.store(count - 1, memory_order_relaxed);
+    node->write_end();
+
+    bool merged = node != head && count - 1 <= MERGE_THRESHOLD && merge(node, preds, succs);
+    node->unlock();
+
+    // Concurrent readers may still be on a merged node, so it is freed once they leave their epoch
+    if(merged){
+        EpochManager::retire(node, destroy_node);
+    }
+
+    // Readers may still hold the value, so it is freed once they leave their epoch
+    EpochManager::retire(removed);
+    return true;
+}
+
+/**
+    Finds the node holding the range of key and reads the value of key from it without locking.
+    Moves right if the node split since the traversal, and starts over if it was merged.
+    Must be called inside an epoch. Return true if the key found
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+bool UnrolledSkipList<Key, Value, K, Compare>::read(const Key &key, Value *&value){
+    while(true){
+        node_type *node = head;
+        for (int level = max_level; level >= 0; level--){
+            while (starts_before(node->next[level], key, true)){
+                node = node->next[level];
+            }
+        }
+
+        while(true){
+            uint32_t version = node->read_begin();
+            bool marked = node->marked;
+            node_type *next = node->next[0];
+            size_t count = node->count.load(memory_order_relaxed);
+            if(count > K){
+                count = K;
+            }
+            size_t slot = position(node, count, key);
+            bool found = slot < count && !compare(key, node->keys[slot]);
+            Value *found_value = found ? node->values[slot] : NULL;
+
+            if(!node->read_validate(version)){
+                continue;
+            }
+            if(marked){
+                break;
+            }
+            if(starts_before(next, key, true)){
+                node = next;
+                continue;
+            }
+            value = found_value;
+            return found;
+        }
+    }
+}
+
+/**
+    Performs search to find if a node exists.
+    Return value if the key found, else return a default constructed value
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+Value UnrolledSkipList<Key, Value, K, Compare>::search(const Key &key){
+    Value value = Value();
+    search(key, [&value](const Value &v){ value = v; });
+    return value;
+}
+
+/**
+    Performs a lock free search and passes a reference to the value to on_found, without copying it.
+    The reference is only valid inside on_found.
+    Return true if the key found
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+template <typename Function>
+bool UnrolledSkipList<Key, Value, K, Compare>::search(const Key &key, Function on_found){
+    EpochGuard guard;
+
+    Value *value;
+    if(!read(key, value)){
+        return false;
+    }
+    on_found(*value);
+    return true;
+}
+
+/**
+    Return true if the key found
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+bool UnrolledSkipList<Key, Value, K, Compare>::contains(const Key &key){
+    EpochGuard guard;
+
+    Value *value;
+    return read(key, value);
+}
+
+/**
+    Walks level 0 from the node holding start_key, or from the head if start_key is NULL, and passes every
+    key and value up to end_key, or to the tail if end_key is NULL, to visitor without copying the values.
+    The entries of every node are copied under one version, a node that was merged meanwhile makes the walk
+    start again after the last key visited. Stops after limit pairs.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+template <typename Function>
+size_t UnrolledSkipList<Key, Value, K, Compare>::walk(const Key *start_key, const Key *end_key, Function visitor, size_t limit){
+    if(limit == 0){
+        return 0;
+    }
+
+    EpochGuard guard;
+
+    node_type* preds[MAX_LEVEL + 1];
+    node_type* succs[MAX_LEVEL + 1];
+    node_type *node = head;
+    if(start_key != NULL){
+        locate(*start_key, preds, succs, true);
+        node = preds[0];
+    }
+
+    Key keys[K];
+    Value *values[K];
+    Key last = start_key != NULL ? *start_key : Key();
+    bool visited_any = false;
+    size_t visited = 0;
+
+    while(node != tail){
+        uint32_t version = node->read_begin();
+        bool marked = node->marked;
+        node_type *next = node->next[0];
+        size_t count = node->count.load(memory_order_relaxed);
+        if(count > K){
+            count = K;
+        }
+        for (size_t i = 0; i < count; i++){
+            keys[i] = node->keys[i];
+            values[i] = node->values[i];
+        }
+
+        if(!node->read_validate(version)){
+            continue;
+        }
+        if(marked){
+            if(visited_any || start_key != NULL){
+                locate(last, preds, succs, true);
+                node = preds[0];
+            }else{
+                node = head;
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < count; i++){
+            if((start_key != NULL && compare(keys[i], *start_key)) || (visited_any && !compare(last, keys[i]))){
+                continue;
+            }
+            if(end_key != NULL && compare(*end_key, keys[i])){
+                return visited;
+            }
+            visitor(keys[i], *values[i]);
+            last = keys[i];
+            visited_any = true;
+            if(++visited == limit){
+                return visited;
+            }
+        }
+        node = next;
+    }
+    return visited;
+}
+
+/**
+    Passes every key and value between start_key and end_key to visitor in key order, at most limit pairs.
+    The references are only valid inside visitor.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+template <typename Function>
+size_t UnrolledSkipList<Key, Value, K, Compare>::scan(const Key &start_key, const Key &end_key, Function visitor, size_t limit){
+    if(compare(end_key, start_key)){
+        return 0;
+    }
+    return walk(&start_key, &end_key, visitor, limit);
+}
+
+/**
+    Passes every key and value of the list to visitor in key order, like scan without bounds.
+    Returns the number of pairs visited.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+template <typename Function>
+size_t UnrolledSkipList<Key, Value, K, Compare>::scan_all(Function visitor){
+    return walk(NULL, NULL, visitor, numeric_limits<size_t>::max());
+}
+
+/**
+    Inserts a batch of key value pairs in key order, one add per key.
+    Keys that already exist and repeated keys after the first are not inserted.
+    Returns the number of keys inserted.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+size_t UnrolledSkipList<Key, Value, K, Compare>::add_batch(const vector<pair<Key, Value> > &batch){
+    const Compare &order = compare;
+    vector<const pair<Key, Value> *> sorted(batch.size());
+    for (size_t j = 0; j < batch.size(); j++){
+        sorted[j] = &batch[j];
+    }
+    stable_sort(sorted.begin(), sorted.end(), [&order](const pair<Key, Value> *a, const pair<Key, Value> *b){
+        return order(a->first, b->first);
+    });
+
+    size_t count = 0;
+    for (size_t j = 0; j < sorted.size(); j++){
+        if(add(sorted[j]->first, sorted[j]->second)){
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+    Deletes a batch of keys in key order, one remove per key.
+    Returns the number of keys deleted.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+size_t UnrolledSkipList<Key, Value, K, Compare>::remove_batch(vector<Key> batch){
+    const Compare &order = compare;
+    sort(batch.begin(), batch.end(), order);
+
+    size_t count = 0;
+    for (size_t j = 0; j < batch.size(); j++){
+        if(remove(batch[j])){
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+    Returns a copy of the key value pairs between start_key and end_key in a map.
+    Use scan to read a range without copying it.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+map<Key, Value, Compare> UnrolledSkipList<Key, Value, K, Compare>::range(const Key &start_key, const Key &end_key){
+    map<Key, Value, Compare> range_output(compare);
+    scan(start_key, end_key, [&range_output](const Key &key, const Value &value){
+        range_output.insert(range_output.end(), make_pair(key, value));
+    });
+    return range_output;
+}
+
+/**
+    Walks level 0 from the head to the tail, one node after the other.
+    Returns the number of keys stored.
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+size_t UnrolledSkipList<Key, Value, K, Compare>::size(){
+    EpochGuard guard;
+
+    size_t count = 0;
+    for (node_type *curr = head; curr != tail; curr = curr->next[0]){
+        if(!curr->marked){
+            count += curr->count.load(memory_order_relaxed);
+        }
+    }
+    return count;
+}
+
+/**
+    Display the skip list in readable format, level 0 shows the keys of every node
+*/
+template <typename Key, typename Value, size_t K, typename Compare>
+void UnrolledSkipList<Key, Value, K, Compare>::display(){
+    for (int i = max_level; i > 0; i--) {
+        if(head->next[i] == tail){
+            continue;
+        }
+        cout << "Level " << i << "  head -> ";
+        for (node_type *temp = head->next[i]; temp != tail; temp = temp->next[i]){
+            cout << temp->anchor << " -> ";
+        }
+        cout << "tail" << endl;
+    }
+    cout << "Level 0  ";
+    for (node_type *temp = head; temp != tail; temp = temp->next[0]){
+        cout << "[";
+        for (size_t j = 0; j < temp->count; j++){
+            cout << (j == 0 ? "" : " ") << temp->keys[j];
+        }
+        cout << "] -> ";
+    }
+    cout << "tail" << endl;
+    printf("---------- Display done! ----------\n\n");
+}
+
+#endif
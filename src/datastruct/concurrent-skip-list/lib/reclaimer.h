@@ -0,0 +1,201 @@
+#ifndef LAZYSKIPLIST_RECLAIMER_H
+#define LAZYSKIPLIST_RECLAIMER_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Memory reclamation policies for LazySkipList.
+// A policy decides how nodes are referenced during traversals and when a removed node is freed.
+
+// Nodes are reference counted, every step of a traversal copies a shared_ptr.
+struct SharedPtrReclaimer {
+  // shared_ptr keeps every node we hold alive, traversals need no extra validation
+  static const bool validatesTraversal = false;
+
+  template <typename Node> using pointer = std::shared_ptr<Node>;
+  template <typename Node> using link = std::shared_ptr<Node>;
+
+  template <typename Node, typename... Args>
+  static pointer<Node> make(Args&&... args) {
+    return std::make_shared<Node>(std::forward<Args>(args)...);
+  }
+
+  template <typename Node>
+  static pointer<Node> protect(const link<Node>& src, int) {
+    return src;
+  }
+
+  template <typename Node>
+  static void hold(int, const pointer<Node>&) {}
+
+  template <typename Node>
+  static void retire(const pointer<Node>&) {}
+
+  // the last shared_ptr to a node frees it
+  template <typename Node>
+  static void destroy(const pointer<Node>&) {}
+
+  static void clear() {}
+};
+
+// Per-process hazard pointer domain. Every thread owns a record of hazard slots and a list of
+// retired nodes, which are freed once no slot of any thread points to them.
+class HazardPointerDomain {
+public:
+  // LazySkipList protects a predecessor and a successor per layer plus a few traversal pointers
+  static const int kSlotsPerThread = 72;
+  // Retired nodes per thread before a scan, scaled by the number of hazard slots in the domain
+  static const size_t kScanFactor = 2;
+
+  struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+  };
+
+  struct Record {
+    std::atomic<void*> hazards[kSlotsPerThread];
+    std::atomic<bool> active;
+    Record* next;
+    std::vector<Retired> retired;
+    // keeps the slots of different threads on different cache lines
+    char padding[64];
+
+    Record() : active(true), next(nullptr) {
+      for (int i = 0; i < kSlotsPerThread; i++)
+        hazards[i].store(nullptr, std::memory_order_relaxed);
+    }
+  };
+
+  static HazardPointerDomain& instance() {
+    static HazardPointerDomain domain;
+    return domain;
+  }
+
+  Record* localRecord() {
+    static thread_local Handle handle;
+    if (handle.record == nullptr)
+      handle.record = acquire();
+    return handle.record;
+  }
+
+  void retire(void* ptr, void (*deleter)(void*)) {
+    Record* rec = localRecord();
+    rec->retired.push_back(Retired{ptr, deleter});
+    size_t threshold = kScanFactor * kSlotsPerThread * recordCount.load(std::memory_order_relaxed);
+    if (rec->retired.size() >= threshold)
+      scan(rec);
+  }
+
+  // frees every retired node of the record that no hazard slot points to
+  void scan(Record* rec) {
+    std::vector<void*> hazards;
+    for (Record* r = records.load(); r != nullptr; r = r->next) {
+      for (int i = 0; i < kSlotsPerThread; i++) {
+        void* p = r->hazards[i].load();
+        if (p != nullptr)
+          hazards.push_back(p);
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    std::vector<Retired> keep;
+    for (auto& r : rec->retired) {
+      if (std::binary_search(hazards.begin(), hazards.end(), r.ptr))
+        keep.push_back(r);
+      else
+        r.deleter(r.ptr);
+    }
+    rec->retired.swap(keep);
+  }
+
+private:
+  // hands the record back when its thread exits; nodes still protected stay for the next owner
+  struct Handle {
+    Record* record = nullptr;
+    ~Handle() {
+      if (record == nullptr)
+        return;
+      for (int i = 0; i < kSlotsPerThread; i++)
+        record->hazards[i].store(nullptr);
+      instance().scan(record);
+      record->active.store(false);
+    }
+  };
+
+  std::atomic<Record*> records;
+  std::atomic<size_t> recordCount;
+
+  HazardPointerDomain() : records(nullptr), recordCount(0) {}
+
+  Record* acquire() {
+    for (Record* r = records.load(); r != nullptr; r = r->next) {
+      bool expected = false;
+      if (!r->active.load() && r->active.compare_exchange_strong(expected, true))
+        return r;
+    }
+    Record* rec = new Record();
+    Record* head = records.load();
+    do {
+      rec->next = head;
+    } while (!records.compare_exchange_weak(head, rec));
+    recordCount.fetch_add(1);
+    return rec;
+  }
+};
+
+// Nodes are plain pointers, traversals publish what they hold in hazard slots.
+struct HazardPointerReclaimer {
+  // a published pointer is only safe if the node it was read from is still in the list
+  static const bool validatesTraversal = true;
+
+  template <typename Node> using pointer = Node*;
+  template <typename Node> using link = std::atomic<Node*>;
+
+  template <typename Node, typename... Args>
+  static pointer<Node> make(Args&&... args) {
+    return new Node(std::forward<Args>(args)...);
+  }
+
+  // reads src into the slot until the published value is confirmed by a second read
+  template <typename Node>
+  static pointer<Node> protect(const link<Node>& src, int slot) {
+    auto& hazard = HazardPointerDomain::instance().localRecord()->hazards[slot];
+    Node* p = src.load();
+    while (true) {
+      hazard.store(p);
+      Node* again = src.load();
+      if (again == p)
+        return p;
+      p = again;
+    }
+  }
+
+  // copies a pointer that is already protected by another slot
+  template <typename Node>
+  static void hold(int slot, Node* p) {
+    HazardPointerDomain::instance().localRecord()->hazards[slot].store(p);
+  }
+
+  template <typename Node>
+  static void retire(Node* p) {
+    HazardPointerDomain::instance().retire(p, [](void* n) { delete static_cast<Node*>(n); });
+  }
+
+  // frees a node no other thread can reach any more, e.g. when the list is destroyed
+  template <typename Node>
+  static void destroy(Node* p) {
+    delete p;
+  }
+
+  // drops every hazard of the calling thread; slots are otherwise overwritten by the next operation
+  static void clear() {
+    auto* rec = HazardPointerDomain::instance().localRecord();
+    for (int i = 0; i < HazardPointerDomain::kSlotsPerThread; i++)
+      rec->hazards[i].store(nullptr, std::memory_order_release);
+  }
+};
+
+#endif //LAZYSKIPLIST_RECLAIMER_H
@@ -9,38 +9,53 @@
 #include <memory>
 #include <vector>
 
-template <typename T>
+#include "reclaimer.h"
+
+// Reclaimer selects how nodes are referenced and freed, see reclaimer.h.
+// SharedPtrReclaimer refcounts every step of a traversal, HazardPointerReclaimer uses raw pointers.
+template <typename T, typename Reclaimer = SharedPtrReclaimer>
 class LazySkipList {
 public:
   static const int MAX_LEVEL = 31;
 
+  class Node;
+  using node_ptr = typename Reclaimer::template pointer<Node>;
+  using node_link = typename Reclaimer::template link<Node>;
+
+  // hazard slots used by traversals: the moving pair, then one predecessor and one successor per layer
+  static const int kPredSlot = 0;
+  static const int kCurrSlot = 1;
+  static const int kPredsSlot = 2;
+  static const int kSuccsSlot = kPredsSlot + MAX_LEVEL + 1;
+  static const int kPoppedSlot = kSuccsSlot + MAX_LEVEL + 1;
+
   class Node {
   public:
     T item;
     int key;
     int topLayer;
-    bool marked;
-    bool fullyLinked;
+    std::atomic<bool> marked;
+    std::atomic<bool> fullyLinked;
 
-    std::shared_ptr<Node> nexts[MAX_LEVEL+1];
+    node_link nexts[MAX_LEVEL+1];
     std::recursive_mutex nodeMutex;
 
     Node(int k) : item(), key(k), topLayer(MAX_LEVEL), marked(false), fullyLinked(false),
                   nodeMutex() {
-      for (int i = 0; i < topLayer; i++)
+      for (int i = 0; i <= MAX_LEVEL; i++)
         nexts[i] = nullptr;
     }
     Node(T x, int height, int k) : item(x), topLayer(height), key(k), marked(false), fullyLinked(false),
                                    nodeMutex() {
-      for (int i = 0; i < topLayer; i++)
+      for (int i = 0; i <= MAX_LEVEL; i++)
         nexts[i] = nullptr;
     }
   };
 
   std::default_random_engine engine;
   std::uniform_int_distribution<unsigned int> distribution;
-  std::shared_ptr<Node> head;
-  std::shared_ptr<Node> tail;
+  node_ptr head;
+  node_ptr tail;
   using u_lock = std::unique_lock<std::recursive_mutex>;
 
   inline unsigned randomLayer() {
@@ -54,48 +69,72 @@ public:
       return 30 - static_cast<unsigned>(log2(randNum)); // p(level=i) = 2**-(i+2)
   }
 
-  inline int find(int k, std::shared_ptr<Node> preds[], std::shared_ptr<Node> succs[]) {
+  // reads pred->nexts[layer]; with a validating reclaimer a marked pred means the read
+  // may have returned an already retired node, so the caller restarts the traversal
+  inline bool step(const node_ptr& pred, int layer, node_ptr& curr) {
+    curr = Reclaimer::template protect<Node>(pred->nexts[layer], kCurrSlot);
+    return !(Reclaimer::validatesTraversal and pred->marked);
+  }
+
+  inline int find(int k, node_ptr preds[], node_ptr succs[]) {
+  retry:
     int lFound = -1;
-    std::shared_ptr<Node> pred = head;
+    node_ptr pred = head;
+    node_ptr curr;
     for (int layer = MAX_LEVEL - 1; layer >= 0; layer--) {
-      std::shared_ptr<Node> curr = pred->nexts[layer];
+      if (!step(pred, layer, curr))
+        goto retry;
       while (k > curr->key) {
         pred = curr;
-        curr = pred->nexts[layer];
+        Reclaimer::hold(kPredSlot, pred);
+        if (!step(pred, layer, curr))
+          goto retry;
       }
       if (lFound == -1 and k == curr->key) {
         lFound = layer;
       }
       preds[layer] = pred;
       succs[layer] = curr;
+      Reclaimer::hold(kPredsSlot + layer, pred);
+      Reclaimer::hold(kSuccsSlot + layer, curr);
     }
     return lFound;
   }
 
-  bool okToDelete(std::shared_ptr<Node> candidate, int lFound) {
+  bool okToDelete(const node_ptr& candidate, int lFound) {
     return (candidate->fullyLinked and
             candidate->topLayer == lFound and
             !candidate->marked);
   }
 
   LazySkipList() : engine(time(nullptr)), distribution() {
-    head = std::make_shared<Node>(std::numeric_limits<int>::lowest());
-    tail = std::make_shared<Node>(std::numeric_limits<int>::max());
+    head = Reclaimer::template make<Node>(std::numeric_limits<int>::lowest());
+    tail = Reclaimer::template make<Node>(std::numeric_limits<int>::max());
     for (int i = 0; i < MAX_LEVEL; i++) {
       head->nexts[i] = tail;
     }
   };
 
+  // frees the nodes still linked at the bottom layer, removed nodes belong to the reclaimer
+  ~LazySkipList() {
+    node_ptr curr = head;
+    while (curr != nullptr) {
+      node_ptr next = curr->nexts[0];
+      Reclaimer::destroy(curr);
+      curr = next;
+    }
+  }
+
 public:
   bool add(T x, int key) {
     int topLayer = randomLayer();
-    std::shared_ptr<Node> preds[MAX_LEVEL+1];
-    std::shared_ptr<Node> succs[MAX_LEVEL+1];
+    node_ptr preds[MAX_LEVEL+1];
+    node_ptr succs[MAX_LEVEL+1];
 
     while (true) {
       auto lFound = find(key, preds, succs);
       if (lFound != -1) {
-        std::shared_ptr<Node> nodeFound = succs[lFound];
+        node_ptr nodeFound = succs[lFound];
         if (!nodeFound->marked) {
           while (!nodeFound->fullyLinked) ;
           //ofs.close();
@@ -103,8 +142,7 @@ public:
         }
         continue;
       }
-      int highestLocked = -1;
-      std::shared_ptr<Node> pred, succ, prevPred = nullptr;
+      node_ptr pred, succ, prevPred = nullptr;
       bool valid = true;
       int layer_count = topLayer + 1;
       std::vector<u_lock> lcks;
@@ -113,37 +151,32 @@ public:
         succ = succs[layer];
         if (pred != prevPred) {
           lcks.emplace_back(u_lock(pred->nodeMutex));
-          highestLocked = layer;
           prevPred = pred;
         }
         valid = !pred->marked and !succ->marked and pred->nexts[layer] == succ;
       }
       if (!valid) {
-        for (int layer = 0; layer <= highestLocked; layer++) {
-          lcks[layer].unlock();
-        }
+        lcks.clear();
         continue;
       }
 
-      auto newNode = std::make_shared<Node>(x, topLayer, key);
+      node_ptr newNode = Reclaimer::template make<Node>(x, topLayer, key);
       for (int layer = 0; layer <= topLayer; layer++) {
         newNode->nexts[layer] = succs[layer];
         preds[layer]->nexts[layer] = newNode;
       }
       newNode->fullyLinked = true;
-      for (int layer = 0; layer <= highestLocked; layer++) {
-        lcks[layer].unlock();
-      }
+      lcks.clear();
       return true;
     }
   }
 
   bool remove(int key) {
-    std::shared_ptr<Node> nodeToDelete = nullptr;
+    node_ptr nodeToDelete = nullptr;
     bool isMarked = false;
     int topLayer = -1;
-    std::shared_ptr<Node> preds[MAX_LEVEL+1];
-    std::shared_ptr<Node> succs[MAX_LEVEL+1];
+    node_ptr preds[MAX_LEVEL+1];
+    node_ptr succs[MAX_LEVEL+1];
     while (true) {
       int lFound = find(key, preds, succs);
       if (isMarked or (lFound != -1 and okToDelete(succs[lFound], lFound))) {
@@ -160,8 +193,7 @@ public:
           isMarked = true;
         }
 
-        int highestLocked = -1;
-        std::shared_ptr<Node> pred, succ, prevPred = nullptr;
+        node_ptr pred, succ, prevPred = nullptr;
         bool valid = true;
         std::vector<u_lock> lcks;
         for (int layer = 0; valid and layer <= topLayer; layer++) {
@@ -169,21 +201,23 @@ public:
           succ = succs[layer];
           if (pred != prevPred) {
             lcks.emplace_back(u_lock(pred->nodeMutex));
-            highestLocked = layer;
             prevPred = pred;
           }
           valid = !pred->marked and pred->nexts[layer] == succ;
         }
         if (!valid) {
-          for (int i = 0; i < highestLocked; i++)
-            lcks[i].unlock();
+          lcks.clear();
           continue;
         }
 
         for (int layer = topLayer; layer >= 0; layer--) {
-          preds[layer]->nexts[layer] = nodeToDelete->nexts[layer];
+          preds[layer]->nexts[layer] = node_ptr(nodeToDelete->nexts[layer]);
         }
-        // RAII: nodeLock and lcks will unlock when return
+        // locks go before the node is retired, the reclaimer may free it right away
+        lcks.clear();
+        if (nodeLock.owns_lock())
+          nodeLock.unlock();
+        Reclaimer::retire(nodeToDelete);
         return true;
       }
       else
@@ -198,13 +232,14 @@ public:
   // may not actually pop first item, but I'm ok with this
   // works same as remove(), gets head->nexts[0]->key as key,
   // though it could not be the first one when removed
-  std::shared_ptr<Node> pop() {
-    std::shared_ptr<Node> nodeToDelete = nullptr;
+  node_ptr pop() {
+    node_ptr nodeToDelete = nullptr;
     bool isMarked = false;
     int topLayer = -1;
-    std::shared_ptr<Node> preds[MAX_LEVEL+1];
-    std::shared_ptr<Node> succs[MAX_LEVEL+1];
-    auto key = head->nexts[0]->key;
+    node_ptr preds[MAX_LEVEL+1];
+    node_ptr succs[MAX_LEVEL+1];
+    node_ptr first = Reclaimer::template protect<Node>(head->nexts[0], kCurrSlot);
+    auto key = first->key;
     while (true) {
       int lFound = find(key, preds, succs);
       if (isMarked or (lFound != -1 and okToDelete(succs[lFound], lFound))) {
@@ -221,8 +256,7 @@ public:
           isMarked = true;
         }
 
-        int highestLocked = -1;
-        std::shared_ptr<Node> pred, succ, prevPred = nullptr;
+        node_ptr pred, succ, prevPred = nullptr;
         bool valid = true;
         std::vector<u_lock> lcks;
         for (int layer = 0; valid and layer <= topLayer; layer++) {
@@ -230,21 +264,24 @@ public:
           succ = succs[layer];
           if (pred != prevPred) {
             lcks.emplace_back(u_lock(pred->nodeMutex));
-            highestLocked = layer;
             prevPred = pred;
           }
           valid = !pred->marked and pred->nexts[layer] == succ;
         }
         if (!valid) {
-          for (int i = 0; i < highestLocked; i++)
-            lcks[i].unlock();
+          lcks.clear();
           continue;
         }
 
         for (int layer = topLayer; layer >= 0; layer--) {
-          preds[layer]->nexts[layer] = nodeToDelete->nexts[layer];
+          preds[layer]->nexts[layer] = node_ptr(nodeToDelete->nexts[layer]);
         }
-        // RAII: nodeLock and lcks will unlock when return
+        lcks.clear();
+        if (nodeLock.owns_lock())
+          nodeLock.unlock();
+        // the popped node stays protected until this thread pops again
+        Reclaimer::hold(kPoppedSlot, nodeToDelete);
+        Reclaimer::retire(nodeToDelete);
         return nodeToDelete;
       }
       else
@@ -4,10 +4,10 @@
 
 using namespace std;
 
-template <typename T>
-std::ostream& operator<<(std::ostream& out, const LazySkipList<T>& lsl) {
+template <typename T, typename R>
+std::ostream& operator<<(std::ostream& out, const LazySkipList<T, R>& lsl) {
   out << "list: " << endl;
-  auto p = lsl.head->nexts[0];
+  typename LazySkipList<T, R>::node_ptr p = lsl.head->nexts[0];
   while (p != lsl.tail) {
     out << p->item << "\t";
     p = p->nexts[0];
@@ -35,5 +35,23 @@ int main() {
   t4.join(); t5.join(); t6.join();
   cout << l << endl;
 
+  // same operations with hazard pointers instead of shared_ptr refcounts
+  using HazardList = LazySkipList<int, HazardPointerReclaimer>;
+  HazardList h;
+
+  std::thread t7(&HazardList::add, &h, 1, 1);
+  std::thread t8(&HazardList::add, &h, 2, 2);
+  std::thread t9(&HazardList::add, &h, 3, 3);
+
+  t7.join(); t8.join(); t9.join();
+  cout << h << endl;
+
+  std::thread t10(&HazardList::remove, &h, 3);
+  std::thread t11(&HazardList::remove, &h, 3);
+  std::thread t12(&HazardList::remove, &h, 2);
+
+  t10.join(); t11.join(); t12.join();
+  cout << h << endl;
+
   return 0;
 }
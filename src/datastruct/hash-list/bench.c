@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <getopt.h>
 #include <limits.h>
+#include <math.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -16,6 +17,9 @@
 #include <time.h>
 
 #include "hash-list.h"
+#include "rcu.h"
+#include "mvrlu.h"
+#include "skip-list.h"
 /////////////////////////////////////////////////////////
 // DEFINES
 /////////////////////////////////////////////////////////
@@ -36,6 +40,27 @@
 #define DEFAULT_SEED                    0
 #define DEFAULT_UPDATE                  200
 #define DEFAULT_ZIPF_DIST_VAL           0
+#define DEFAULT_SET_TYPE                "pure"
+#define DEFAULT_LOAD_FACTOR             0
+#define DEFAULT_GROW                    0
+#define DEFAULT_HASH                    "fibonacci"
+
+/* Chain lengths the --chains histogram counts, longer ones are counted together,
+ * and the ranges it prints */
+#define CHAIN_COUNTS                    4096
+#define CHAIN_RANGES                    16
+
+/* Latency bins: exact below 8ns, then 8 bins per power of two */
+#define LATENCY_SUB_BITS                3
+#define LATENCY_BINS                    (64 << LATENCY_SUB_BITS)
+
+/* Synchronization of the set, selected with --set-type */
+#define SET_TYPE_PURE                   0
+#define SET_TYPE_RCU                    1
+#define SET_TYPE_MVRLU                  2
+#define SET_TYPE_MVRLU_SKIP_LIST        3
+
+#define IS_MVRLU(set_type)              ((set_type) == SET_TYPE_MVRLU || (set_type) == SET_TYPE_MVRLU_SKIP_LIST)
 
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
@@ -53,6 +78,8 @@
 typedef struct thread_data {
 	long uniq_id;
 	hash_list_t *p_hash_list;
+	skip_list_t *p_skip_list;
+	rlu_thread_data_t *p_rlu;
 	struct barrier *barrier;
 	unsigned long nb_add;
 	unsigned long nb_remove;
@@ -64,6 +91,11 @@ typedef struct thread_data {
 	int range;
 	int update;
 	int alternate;	
+	/* Grow mode: keys this thread adds, and latencies of its operations */
+	long grow;
+	int nb_threads;
+	unsigned long *add_latencies;
+	unsigned long *contains_latencies;
 	char padding[64];
 } thread_data_t;
 
@@ -80,6 +112,7 @@ typedef struct barrier {
 static volatile long padding[50];
 
 static volatile int stop;
+static int set_type = SET_TYPE_PURE;
 static unsigned short main_seed[3];
 static cpu_set_t cpu_set[450];
 
@@ -118,6 +151,77 @@ static inline int rand_range(int n, unsigned short *seed)
   return v;
 }
 
+static inline unsigned long now_ns()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static inline int latency_bin(unsigned long ns)
+{
+  int e;
+
+  if (ns < (1UL << LATENCY_SUB_BITS)) {
+    return (int)ns;
+  }
+  e = 63 - __builtin_clzl(ns);
+  return ((e - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+    (int)((ns >> (e - LATENCY_SUB_BITS)) & ((1 << LATENCY_SUB_BITS) - 1));
+}
+
+/* Smallest latency of a bin */
+static inline unsigned long latency_bin_ns(int bin)
+{
+  int e = (bin >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+
+  if (bin < (1 << LATENCY_SUB_BITS)) {
+    return bin;
+  }
+  return (1UL << e) + ((unsigned long)(bin & ((1 << LATENCY_SUB_BITS) - 1)) << (e - LATENCY_SUB_BITS));
+}
+
+static unsigned long *latencies_new()
+{
+  unsigned long *latencies = (unsigned long *)calloc(LATENCY_BINS, sizeof(unsigned long));
+
+  if (latencies == NULL) {
+    perror("calloc");
+    exit(1);
+  }
+  return latencies;
+}
+
+static void latencies_print(const char *name, unsigned long *latencies)
+{
+  int bin, i;
+  unsigned long count = 0, seen = 0, max = 0;
+  double percentiles[] = { 0.5, 0.99, 0.999 };
+  unsigned long values[3] = { 0, 0, 0 };
+
+  for (bin = 0; bin < LATENCY_BINS; bin++) {
+    count += latencies[bin];
+    if (latencies[bin] != 0) {
+      max = latency_bin_ns(bin);
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+
+  i = 0;
+  for (bin = 0; bin < LATENCY_BINS && i < 3; bin++) {
+    seen += latencies[bin];
+    while (i < 3 && seen >= percentiles[i] * count) {
+      values[i++] = latency_bin_ns(bin);
+    }
+  }
+
+  printf("%-13s : %lu ops, p50 %lu ns, p99 %lu ns, p99.9 %lu ns, max %lu ns\n",
+    name, count, values[0], values[1], values[2], max);
+}
+
 static void barrier_init(barrier_t *b, int n)
 {
   pthread_cond_init(&b->complete, NULL);
@@ -146,30 +250,147 @@ static void barrier_cross(barrier_t *b)
 // FUNCTIONS
 /////////////////////////////////////////////////////////
 static void thread_init(thread_data_t *d) {
+	if (set_type == SET_TYPE_RCU) {
+		rcu_register(d->uniq_id);
+	} else if (IS_MVRLU(set_type)) {
+		if (posix_memalign((void **)&d->p_rlu, RLU_CACHE_LINE, sizeof(rlu_thread_data_t)) != 0) {
+			perror("posix_memalign");
+			exit(1);
+		}
+		rlu_thread_init(d->p_rlu);
+	}
 }
 
 static void thread_finish(thread_data_t *d) {
+	if (set_type == SET_TYPE_RCU) {
+		rcu_unregister();
+	} else if (IS_MVRLU(set_type)) {
+		rlu_thread_finish(d->p_rlu);
+	}
 }
 
 static void print_stats() {
+	if (IS_MVRLU(set_type)) {
+		rlu_print_stats();
+	}
 }
 
-static void hash_list_init(hash_list_t **pp, int n_buckets) {
-	*pp = pure_new_hash_list(n_buckets);
+static void hash_list_init(hash_list_t **pp, int n_buckets, int load_factor, int hash_type) {
+	if (set_type == SET_TYPE_MVRLU) {
+		*pp = rlu_new_hash_list(n_buckets, hash_type);
+	} else {
+		*pp = pure_new_hash_list(n_buckets, load_factor, hash_type);
+	}
+}
+
+/* Groups the chain lengths in CHAIN_RANGES ranges of equal width up to the longest chain */
+static void print_chains(hash_list_t *p_hash_list) {
+	int i, longest, last, width;
+	unsigned long *counts, ranges[CHAIN_RANGES];
+	unsigned long n_buckets = 0;
+	double mean, variance = 0;
+
+	if ((counts = (unsigned long *)malloc(CHAIN_COUNTS * sizeof(unsigned long))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+
+	longest = hash_list_chains(p_hash_list, counts, CHAIN_COUNTS);
+	for (i = 0; i < CHAIN_COUNTS; i++) {
+		n_buckets += counts[i];
+	}
+	mean = (double)hash_list_size(p_hash_list) / n_buckets;
+	for (i = 0; i < CHAIN_COUNTS; i++) {
+		variance += counts[i] * (i - mean) * (i - mean);
+	}
+	variance /= n_buckets;
+
+	last = longest < CHAIN_COUNTS ? longest : CHAIN_COUNTS - 1;
+	width = last / CHAIN_RANGES + 1;
+	for (i = 0; i < CHAIN_RANGES; i++) {
+		ranges[i] = 0;
+	}
+	for (i = 0; i <= last; i++) {
+		ranges[i / width] += counts[i];
+	}
+
+	printf("Chain lengths : mean %.2f, stddev %.2f, longest %d\n", mean, sqrt(variance), longest);
+	for (i = 0; i * width <= last; i++) {
+		if (width == 1) {
+			printf("  %9d : %lu (%.2f%%)\n", i, ranges[i], ranges[i] * 100.0 / n_buckets);
+		} else {
+			printf("  %4d-%-4d : %lu (%.2f%%)\n", i * width, (i + 1) * width - 1,
+				ranges[i], ranges[i] * 100.0 / n_buckets);
+		}
+	}
+
+	free(counts);
 }
 
 static int hash_list_contains(thread_data_t *d, int key) {
+	if (set_type == SET_TYPE_RCU) {
+		return rcu_hash_list_contains(d->p_hash_list, key);
+	} else if (set_type == SET_TYPE_MVRLU) {
+		return rlu_hash_list_contains(d->p_rlu, d->p_hash_list, key);
+	} else if (set_type == SET_TYPE_MVRLU_SKIP_LIST) {
+		return rlu_skip_list_contains(d->p_rlu, d->p_skip_list, key);
+	}
 	return pure_hash_list_contains(d->p_hash_list, key);
 }
 
 static int hash_list_add(thread_data_t *d, int key) {
+	if (set_type == SET_TYPE_RCU) {
+		return rcu_hash_list_add(d->p_hash_list, key);
+	} else if (set_type == SET_TYPE_MVRLU) {
+		return rlu_hash_list_add(d->p_rlu, d->p_hash_list, key);
+	} else if (set_type == SET_TYPE_MVRLU_SKIP_LIST) {
+		return rlu_skip_list_add(d->p_rlu, d->p_skip_list, key);
+	}
 	return pure_hash_list_add(d->p_hash_list, key);
 }
 
 static int hash_list_remove(thread_data_t *d, int key) {
+	if (set_type == SET_TYPE_RCU) {
+		return rcu_hash_list_remove(d->p_hash_list, key);
+	} else if (set_type == SET_TYPE_MVRLU) {
+		return rlu_hash_list_remove(d->p_rlu, d->p_hash_list, key);
+	} else if (set_type == SET_TYPE_MVRLU_SKIP_LIST) {
+		return rlu_skip_list_remove(d->p_rlu, d->p_skip_list, key);
+	}
 	return pure_hash_list_remove(d->p_hash_list, key);
 }
 
+/* Adds keys above the range that no other thread adds, timing every
+ * operation. Lookups of the keys already added follow the update rate. */
+static void grow(thread_data_t *d)
+{
+	long added = 0;
+	int key, op;
+	unsigned long start;
+
+	while (added < d->grow) {
+		op = rand_range(1000, d->seed);
+		if (op < d->update || added == 0) {
+			key = d->range + 1 + added * d->nb_threads + d->uniq_id;
+			start = now_ns();
+			if (hash_list_add(d, key)) {
+				d->diff++;
+			}
+			d->add_latencies[latency_bin(now_ns() - start)]++;
+			d->nb_add++;
+			added++;
+		} else {
+			key = d->range + 1 + rand_range(added, d->seed) * d->nb_threads + d->uniq_id;
+			start = now_ns();
+			if (hash_list_contains(d, key)) {
+				d->nb_found++;
+			}
+			d->contains_latencies[latency_bin(now_ns() - start)]++;
+			d->nb_contains++;
+		}
+	}
+}
+
 static void *test(void *data)
 {
 	int op, last = -1;
@@ -195,6 +416,13 @@ static void *test(void *data)
 	/* Wait on barrier */
 	barrier_cross(d->barrier);
 
+	if (d->grow > 0) {
+		grow(d);
+		barrier_cross(d->barrier);
+		thread_finish(d);
+		return NULL;
+	}
+
 	while (stop == 0) {
 		op = rand_range(1000, d->seed);
 		if (op < d->update) {
@@ -265,10 +493,16 @@ int main(int argc, char **argv)
 			{"zipf-dist-val",             required_argument, NULL, 'z'},
 			{"rlu-max-ws",                required_argument, NULL, 'w'},
 			{"update-rate",               required_argument, NULL, 'u'},
+			{"set-type",                  required_argument, NULL, 't'},
+			{"load-factor",               required_argument, NULL, 'l'},
+			{"grow",                      required_argument, NULL, 'g'},
+			{"hash",                      required_argument, NULL, 'k'},
+			{"chains",                    no_argument,       NULL, 'c'},
 			{NULL, 0, NULL, 0}
 	};
 
-	hash_list_t *p_hash_list;
+	hash_list_t *p_hash_list = NULL;
+	skip_list_t *p_skip_list = NULL;
 	int i, c, size, size2;
 	unsigned long reads, updates;
 	thread_data_t *data;
@@ -285,11 +519,18 @@ int main(int argc, char **argv)
 	int seed = DEFAULT_SEED;
 	int update = DEFAULT_UPDATE;
 	int alternate = 1;
+	int rlu_max_ws = RLU_DEFAULT_MAX_WS;
+	int load_factor = DEFAULT_LOAD_FACTOR;
+	long grow_size = DEFAULT_GROW;
+	int hash_type = HASH_TYPE_FIBONACCI;
+	const char *hash_name = DEFAULT_HASH;
+	int chains = 0;
+	unsigned long *add_latencies, *contains_latencies;
 	sigset_t block_set;
 
 	while(1) {
 		i = 0;
-		c = getopt_long(argc, argv, "hab:d:i:n:r:s:w:u:z:", long_options, &i);
+		c = getopt_long(argc, argv, "hab:cd:g:i:k:l:n:r:s:t:w:u:z:", long_options, &i);
 
 		if(c == -1)
 			break;
@@ -314,7 +555,9 @@ int main(int argc, char **argv)
 				"  -a, --do-not-alternate\n"
 				"        Do not alternate insertions and removals\n"
 				"  -b, --buckets <int>\n"
-				"        Number of buckets (default=" XSTR(DEFAULT_BUCKETS) ")\n"
+				"        Number of buckets, rounded up to a power of two (default=" XSTR(DEFAULT_BUCKETS) ")\n"
+				"  -c, --chains\n"
+				"        Print the histogram of the chain lengths at the end\n"
 				"  -d, --duration <int>\n"
 				"        Test duration in milliseconds (0=infinite, default=" XSTR(DEFAULT_DURATION) ")\n"
 				"  -i, --initial-size <int>\n"
@@ -327,6 +570,18 @@ int main(int argc, char **argv)
 				"        RNG seed (0=time-based, default=" XSTR(DEFAULT_SEED) ")\n"
 				"  -u, --update-rate <int>\n"
 				"        Percentage of update transactions (1000 = 100 percent) (default=" XSTR(DEFAULT_UPDATE) ")\n"				
+				"  -t, --set-type <pure|rcu|mvrlu|mvrlu-skip-list>\n"
+				"        pure: readers validate a per-bucket version, rcu: readers in RCU sections,\n"
+				"        mvrlu: hash-list on MV-RLU, mvrlu-skip-list: skip list on MV-RLU (default=" DEFAULT_SET_TYPE ")\n"
+				"  -w, --rlu-max-ws <int>\n"
+				"        MV-RLU write sets a thread leaves to the garbage collector before it waits (default=" XSTR(RLU_DEFAULT_MAX_WS) ")\n"
+				"  -l, --load-factor <int>\n"
+				"        Keys per bucket that double the buckets of a pure set (0=fixed, default=" XSTR(DEFAULT_LOAD_FACTOR) ")\n"
+				"  -g, --grow <int>\n"
+				"        Add new keys until the set holds <int>, timing every operation; the update rate\n"
+				"        is the share of adds and the duration is ignored (0=off, default=" XSTR(DEFAULT_GROW) ")\n"
+				"  -k, --hash <identity|fibonacci|murmur3|crc32c>\n"
+				"        Function whose low bits pick the bucket of a key (default=" DEFAULT_HASH ")\n"
 				);
 			exit(0);
 			case 'a':
@@ -353,6 +608,51 @@ int main(int argc, char **argv)
 			case 'u':
 			update = atoi(optarg);
 			break;
+			case 'w':
+			rlu_max_ws = atoi(optarg);
+			break;
+			case 'l':
+			load_factor = atoi(optarg);
+			break;
+			case 'g':
+			grow_size = atol(optarg);
+			break;
+			case 'c':
+			chains = 1;
+			break;
+			case 'k':
+			hash_name = optarg;
+			if (strcmp(optarg, "identity") == 0) {
+				hash_type = HASH_TYPE_IDENTITY;
+			} else if (strcmp(optarg, "fibonacci") == 0) {
+				hash_type = HASH_TYPE_FIBONACCI;
+			} else if (strcmp(optarg, "murmur3") == 0) {
+				hash_type = HASH_TYPE_MURMUR3;
+			} else if (strcmp(optarg, "crc32c") == 0) {
+				hash_type = HASH_TYPE_CRC32C;
+			} else {
+				printf("Unknown hash %s\n", optarg);
+				exit(1);
+			}
+			if (!hash_type_supported(hash_type)) {
+				printf("Hash %s is not supported by this CPU\n", optarg);
+				exit(1);
+			}
+			break;
+			case 't':
+			if (strcmp(optarg, "pure") == 0) {
+				set_type = SET_TYPE_PURE;
+			} else if (strcmp(optarg, "rcu") == 0) {
+				set_type = SET_TYPE_RCU;
+			} else if (strcmp(optarg, "mvrlu") == 0) {
+				set_type = SET_TYPE_MVRLU;
+			} else if (strcmp(optarg, "mvrlu-skip-list") == 0) {
+				set_type = SET_TYPE_MVRLU_SKIP_LIST;
+			} else {
+				printf("Unknown set type %s\n", optarg);
+				exit(1);
+			}
+			break;
 			case '?':
 			printf("Use -h or --help for help\n");
 			exit(0);
@@ -369,9 +669,23 @@ int main(int argc, char **argv)
 	assert(nb_threads > 0);
 	assert(range > 0 && range >= initial);
 	assert(update >= 0 && update <= 1000);
-
-	printf("Set type     : hash-list\n");
+	assert(set_type != SET_TYPE_RCU || nb_threads <= RCU_MAX_THREADS);
+	assert(!IS_MVRLU(set_type) || (nb_threads <= RLU_MAX_THREADS && rlu_max_ws > 0));
+	assert(load_factor >= 0 && (load_factor == 0 || set_type == SET_TYPE_PURE));
+	assert(grow_size == 0 || (grow_size > initial && update > 0));
+	assert(grow_size <= INT_MAX - range);
+
+	printf("Set type     : %s (%s)\n", set_type == SET_TYPE_MVRLU_SKIP_LIST ? "skip-list" : "hash-list",
+		set_type == SET_TYPE_RCU ? "rcu" : IS_MVRLU(set_type) ? "mvrlu" : "pure");
+	if (IS_MVRLU(set_type)) {
+		printf("RLU max ws   : %d\n", rlu_max_ws);
+	}
 	printf("Buckets      : %d\n", n_buckets);
+	printf("Hash         : %s\n", hash_name);
+	printf("Load factor  : %d\n", load_factor);
+	if (grow_size > 0) {
+		printf("Grow to      : %ld\n", grow_size);
+	}
 	printf("Duration     : %d\n", duration);
 	printf("Initial size : %d\n", initial);
 	printf("Nb threads   : %d\n", nb_threads);
@@ -407,7 +721,14 @@ int main(int argc, char **argv)
 		srand(seed);
 	
 	
-	hash_list_init(&p_hash_list, n_buckets);
+	if (IS_MVRLU(set_type)) {
+		rlu_init(rlu_max_ws);
+	}
+	if (set_type == SET_TYPE_MVRLU_SKIP_LIST) {
+		p_skip_list = rlu_new_skip_list();
+	} else {
+		hash_list_init(&p_hash_list, n_buckets, load_factor, hash_type);
+	}
 
 	size = initial;
 	
@@ -441,8 +762,14 @@ int main(int argc, char **argv)
 		data[i].nb_found = 0;
 		data[i].initial = initial;
 		data[i].diff = 0;
+		data[i].nb_threads = nb_threads;
+		data[i].grow = grow_size > 0 ?
+			(grow_size - initial) / nb_threads + (i < (grow_size - initial) % nb_threads) : 0;
+		data[i].add_latencies = latencies_new();
+		data[i].contains_latencies = latencies_new();
 		rand_init(data[i].seed);
 		data[i].p_hash_list = p_hash_list;
+		data[i].p_skip_list = p_skip_list;
 		data[i].barrier = &barrier;
 		if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
 			fprintf(stderr, "Error creating thread\n");
@@ -456,7 +783,10 @@ int main(int argc, char **argv)
 
 	printf("STARTING THREADS...\n");
 	gettimeofday(&start, NULL);
-	if (duration > 0) {
+	if (grow_size > 0) {
+		/* The threads are done once every key is added */
+		barrier_cross(&barrier);
+	} else if (duration > 0) {
 		nanosleep(&timeout, NULL);
 	} else {
 		sigemptyset(&block_set);
@@ -489,12 +819,44 @@ int main(int argc, char **argv)
 		updates += (data[i].nb_add + data[i].nb_remove);
 		size += data[i].diff;
 	}
-	size2 = hash_list_size(p_hash_list);
+	/* Writes every MV-RLU copy back, so the sizes below can read the nodes directly */
+	if (IS_MVRLU(set_type)) {
+		rlu_finish();
+	}
+	if (set_type == SET_TYPE_MVRLU_SKIP_LIST) {
+		size2 = skip_list_size(p_skip_list);
+	} else {
+		size2 = hash_list_size(p_hash_list);
+	}
 	printf("Set size      : %d (expected: %d)\n", size2, size);
+	if (set_type != SET_TYPE_MVRLU_SKIP_LIST) {
+		printf("Buckets       : %d\n", hash_list_buckets(p_hash_list));
+		if (chains) {
+			print_chains(p_hash_list);
+		}
+	}
 	printf("Duration      : %d (ms)\n", duration);
 	printf("#ops          : %lu (%f / s)\n", reads + updates, (reads + updates) * 1000.0 / duration);
 	printf("#read ops     : %lu (%f / s)\n", reads, reads * 1000.0 / duration);
 	printf("#update ops   : %lu (%f / s)\n", updates, updates * 1000.0 / duration);
+	if (grow_size > 0) {
+		add_latencies = latencies_new();
+		contains_latencies = latencies_new();
+		for (i = 0; i < nb_threads; i++) {
+			for (c = 0; c < LATENCY_BINS; c++) {
+				add_latencies[c] += data[i].add_latencies[c];
+				contains_latencies[c] += data[i].contains_latencies[c];
+			}
+		}
+		latencies_print("add latency", add_latencies);
+		latencies_print("contains lat.", contains_latencies);
+		free(add_latencies);
+		free(contains_latencies);
+	}
+	for (i = 0; i < nb_threads; i++) {
+		free(data[i].add_latencies);
+		free(data[i].contains_latencies);
+	}
 
 	free(threads);
 	free(data);
@@ -504,7 +866,11 @@ int main(int argc, char **argv)
 	fflush(stdout);
 	if (size != size2) {
 		printf("\n<<<<<<<<<<<<<< ASSERT FAILURE <<<<<<<<<<<<<<<<<<<\n");
-		hash_list_print(p_hash_list);
+		if (set_type == SET_TYPE_MVRLU_SKIP_LIST) {
+			skip_list_print(p_skip_list);
+		} else {
+			hash_list_print(p_hash_list);
+		}
 		printf("\n>>>>>>>>>>>>>> ASSERT FAILURE >>>>>>>>>>>>>>>>>>>\n");
 		fflush(stdout);
 	}
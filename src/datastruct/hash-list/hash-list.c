@@ -4,25 +4,108 @@
 /////////////////////////////////////////////////////////
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include "types.h"
+#include "rcu.h"
+#include "mvrlu.h"
 #include <pthread.h>
 
 /////////////////////////////////////////////////////////
 // DEFINES
 /////////////////////////////////////////////////////////
-#define HASH_VALUE(p_hash_list, val)       (val % p_hash_list->n_buckets)
+#define HASH_VALUE(p_table, val)           (hash_mix((p_table)->hash_type, (val)) & (p_table)->mask)
+
+/* 2^64 / golden ratio, and the constants of the murmur3 32-bit finalizer */
+#define FIBONACCI_MULTIPLIER     (0x9E3779B97F4A7C15ULL)
+#define MURMUR3_C1               (0x85EBCA6BU)
+#define MURMUR3_C2               (0xC2B2AE35U)
 
 #define MEMBARSTLD() __sync_synchronize()
 #ifndef CAS
 #define CAS(addr, expected_value, new_value) __sync_val_compare_and_swap((addr), (expected_value), (new_value))
 #endif
 
+#define LOAD_ACQUIRE(x)          __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define LOAD_RELAXED(x)          __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STORE_RELEASE(x, v)      __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define STORE_RELAXED(x, v)      __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define FENCE_ACQUIRE()          __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define FENCE_RELEASE()          __atomic_thread_fence(__ATOMIC_RELEASE)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX()              __asm__ __volatile__("pause" ::: "memory")
+#else
+#define CPU_RELAX()              __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* Returned by the list operations when the bucket moved to the next table */
+#define BUCKET_MIGRATED         (-1)
+/* Buckets a writer moves to the next table per operation while resizing */
+#define MIGRATE_STEP            (4)
+
+/* Free nodes a thread keeps, and the nodes it moves to or from the shared pool at once */
+#define NODE_CACHE_MAX          (256)
+#define NODE_CACHE_BATCH        (128)
+
+/////////////////////////////////////////////////////////
+// NODE POOL
+/////////////////////////////////////////////////////////
+/* Removed nodes are never returned to malloc, they are kept in a
+ * per-thread cache and a shared pool and reused by later adds.
+ * A reader that walks a bucket without its lock may still be on a
+ * removed node, so every pointer it follows must point to a node. */
+static __thread node_t *p_node_cache = NULL;
+static __thread int n_node_cache = 0;
+
+static node_t *p_node_pool = NULL;
+static pthread_mutex_t node_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void node_cache_refill() {
+	node_t *p_node;
+
+	pthread_mutex_lock(&node_pool_lock);
+	while (p_node_pool != NULL && n_node_cache < NODE_CACHE_BATCH) {
+		p_node = p_node_pool;
+		p_node_pool = p_node->p_next;
+		STORE_RELAXED(p_node->p_next, p_node_cache);
+		p_node_cache = p_node;
+		n_node_cache++;
+	}
+	pthread_mutex_unlock(&node_pool_lock);
+}
+
+static void node_cache_flush() {
+	node_t *p_node;
+
+	pthread_mutex_lock(&node_pool_lock);
+	while (n_node_cache > NODE_CACHE_MAX - NODE_CACHE_BATCH) {
+		p_node = p_node_cache;
+		p_node_cache = p_node->p_next;
+		STORE_RELAXED(p_node->p_next, p_node_pool);
+		p_node_pool = p_node;
+		n_node_cache--;
+	}
+	pthread_mutex_unlock(&node_pool_lock);
+}
+
 /////////////////////////////////////////////////////////
 // NEW NODE
 /////////////////////////////////////////////////////////
 node_t *pure_new_node() {
+	node_t *p_new_node;
+
+	if (p_node_cache == NULL) {
+		node_cache_refill();
+	}
+
+	if (p_node_cache != NULL) {
+		p_new_node = p_node_cache;
+		p_node_cache = p_new_node->p_next;
+		n_node_cache--;
+		return p_new_node;
+	}
 
-	node_t *p_new_node = (node_t *)malloc(sizeof(node_t));
+	p_new_node = (node_t *)malloc(sizeof(node_t));
 	if (p_new_node == NULL){
 		printf("out of memory\n");
 		exit(1);
@@ -36,11 +119,82 @@ node_t *pure_new_node() {
 /////////////////////////////////////////////////////////
 void pure_free_node(node_t *p_node) {
 	if (p_node != NULL) {
-		free(p_node);
+		STORE_RELAXED(p_node->p_next, p_node_cache);
+		p_node_cache = p_node;
+		n_node_cache++;
+
+		if (n_node_cache > NODE_CACHE_MAX) {
+			node_cache_flush();
+		}
 	}
 }
 
 
+/////////////////////////////////////////////////////////
+// HASH
+/////////////////////////////////////////////////////////
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse4.2")))
+static unsigned int hash_crc32c(unsigned int key)
+{
+	return __builtin_ia32_crc32si(0xFFFFFFFFU, key);
+}
+#else
+static unsigned int hash_crc32c(unsigned int key)
+{
+	return key;
+}
+#endif
+
+int hash_type_supported(int hash_type)
+{
+	if (hash_type == HASH_TYPE_CRC32C) {
+#if defined(__x86_64__) || defined(__i386__)
+		return __builtin_cpu_supports("sse4.2");
+#else
+		return 0;
+#endif
+	}
+	return hash_type >= HASH_TYPE_IDENTITY && hash_type <= HASH_TYPE_MURMUR3;
+}
+
+/* The bucket is the low bits of the hash, so a bucket of a table splits
+ * into the same bucket and the one n above it in a table of twice the
+ * buckets. Identity keeps the key, the others mix its high bits in. */
+static inline unsigned int hash_mix(int hash_type, val_t val)
+{
+	unsigned int h = (unsigned int)val;
+	uint64_t product;
+
+	switch (hash_type) {
+	case HASH_TYPE_FIBONACCI:
+		/* The best mixed bits of the product are the top ones, fold them onto the bits the mask keeps */
+		product = (uint64_t)h * FIBONACCI_MULTIPLIER;
+		return (unsigned int)((product ^ (product >> 16)) >> 32);
+	case HASH_TYPE_MURMUR3:
+		h ^= h >> 16;
+		h *= MURMUR3_C1;
+		h ^= h >> 13;
+		h *= MURMUR3_C2;
+		h ^= h >> 16;
+		return h;
+	case HASH_TYPE_CRC32C:
+		return hash_crc32c(h);
+	}
+	return h;
+}
+
+/* Smallest power of two of at least n buckets */
+static int round_buckets(int n_buckets)
+{
+	int n = 1;
+
+	while (n < n_buckets && n < MAX_BUCKETS) {
+		n <<= 1;
+	}
+	return n;
+}
+
 /////////////////////////////////////////////////////////
 // NEW LIST
 /////////////////////////////////////////////////////////
@@ -68,14 +222,48 @@ list_t *pure_new_list()
 	p_min_node->p_next = p_max_node;
 
 	p_list->p_head = p_min_node;
+	p_list->version = 0;
+	p_list->migrated = 0;
+	p_list->size = 0;
 
 	return p_list;
 }
 
+/////////////////////////////////////////////////////////
+// NEW TABLE
+/////////////////////////////////////////////////////////
+/* The buckets are left NULL for the caller to fill */
+static table_t *new_table(int n_buckets, int hash_type)
+{
+	table_t *p_table;
+
+	p_table = (table_t *)malloc(sizeof(table_t));
+	if (p_table == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+
+	p_table->buckets = (list_t **)calloc(n_buckets, sizeof(list_t *));
+	if (p_table->buckets == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+
+	p_table->n_buckets = n_buckets;
+	p_table->mask = n_buckets - 1;
+	p_table->hash_type = hash_type;
+	p_table->p_next = NULL;
+	p_table->migrate_next = 0;
+	p_table->n_migrated = 0;
+	p_table->p_retired = NULL;
+
+	return p_table;
+}
+
 /////////////////////////////////////////////////////////
 // NEW HASH LIST
 /////////////////////////////////////////////////////////
-hash_list_t *pure_new_hash_list(int n_buckets)
+static hash_list_t *new_hash_list(table_t *p_table, int load_factor)
 {
 	int i;
 	hash_list_t *p_hash_list;
@@ -87,15 +275,31 @@ hash_list_t *pure_new_hash_list(int n_buckets)
 	    exit(1);
 	}
 
-	p_hash_list->n_buckets = n_buckets;
-
-	for (i = 0; i < p_hash_list->n_buckets; i++) {
-		p_hash_list->buckets[i] = pure_new_list();
+	p_hash_list->n_buckets = p_table->n_buckets;
+	p_hash_list->load_factor = load_factor;
+	p_hash_list->p_table = p_table;
+	pthread_mutex_init(&p_hash_list->resize_lock, NULL);
+	for (i = 0; i < SIZE_STRIPES; i++) {
+		p_hash_list->sizes[i].count = 0;
 	}
 
 	return p_hash_list;
 }
 
+hash_list_t *pure_new_hash_list(int n_buckets, int load_factor, int hash_type)
+{
+	int i;
+	table_t *p_table;
+
+	n_buckets = round_buckets(n_buckets);
+	p_table = new_table(n_buckets, hash_type);
+	for (i = 0; i < n_buckets; i++) {
+		p_table->buckets[i] = pure_new_list();
+	}
+
+	return new_hash_list(p_table, load_factor);
+}
+
 
 /////////////////////////////////////////////////////////
 // LIST SIZE
@@ -130,44 +334,250 @@ void list_print(list_t *p_list)
 /////////////////////////////////////////////////////////
 // HASH LIST SIZE
 /////////////////////////////////////////////////////////
+/* A bucket that moved is split over buckets hash and hash + n of the next table */
+static int bucket_size(table_t *p_table, int hash)
+{
+	if (p_table->buckets[hash]->migrated) {
+		return bucket_size(p_table->p_next, hash) +
+			bucket_size(p_table->p_next, hash + p_table->n_buckets);
+	}
+	return list_size(p_table->buckets[hash]);
+}
+
+static void bucket_print(table_t *p_table, int hash)
+{
+	if (p_table->buckets[hash]->migrated) {
+		bucket_print(p_table->p_next, hash);
+		bucket_print(p_table->p_next, hash + p_table->n_buckets);
+		return;
+	}
+	list_print(p_table->buckets[hash]);
+}
+
 int hash_list_size(hash_list_t *p_hash_list)
 {
 	int i;
 	int size = 0;
+	table_t *p_table = p_hash_list->p_table;
+
+	for (i = 0; i < p_table->n_buckets; i++) {
+		size += bucket_size(p_table, i);
+	}
 
-	for (i = 0; i < p_hash_list->n_buckets; i++) {
-		size += list_size(p_hash_list->buckets[i]);
+	return size;
+}
+
+/* Counts the buckets of the newest table by chain length, chains of
+ * n_counts - 1 keys or more in the last count. Returns the longest chain. */
+static int bucket_chains(table_t *p_table, int hash, unsigned long *counts, int n_counts)
+{
+	int size, longest;
+
+	if (p_table->buckets[hash]->migrated) {
+		size = bucket_chains(p_table->p_next, hash, counts, n_counts);
+		longest = bucket_chains(p_table->p_next, hash + p_table->n_buckets, counts, n_counts);
+		return size > longest ? size : longest;
 	}
 
+	size = list_size(p_table->buckets[hash]);
+	counts[size < n_counts ? size : n_counts - 1]++;
 	return size;
 }
 
+int hash_list_chains(hash_list_t *p_hash_list, unsigned long *counts, int n_counts)
+{
+	int i, size, longest = 0;
+	table_t *p_table = p_hash_list->p_table;
+
+	for (i = 0; i < n_counts; i++) {
+		counts[i] = 0;
+	}
+	for (i = 0; i < p_table->n_buckets; i++) {
+		size = bucket_chains(p_table, i, counts, n_counts);
+		if (size > longest) {
+			longest = size;
+		}
+	}
+
+	return longest;
+}
+
+/* Buckets of the newest table */
+int hash_list_buckets(hash_list_t *p_hash_list)
+{
+	table_t *p_table = p_hash_list->p_table;
+
+	while (p_table->p_next != NULL) {
+		p_table = p_table->p_next;
+	}
+	return p_table->n_buckets;
+}
+
 void hash_list_print(hash_list_t *p_hash_list)
 {
 	int i;
+	table_t *p_table = p_hash_list->p_table;
+
+	for (i = 0; i < p_table->n_buckets; i++) {
+		bucket_print(p_table, i);
+	}
+}
+
+/////////////////////////////////////////////////////////
+// RESIZE
+/////////////////////////////////////////////////////////
+/* Keys added minus keys removed by the calling thread go to one of the
+ * stripes, so threads rarely update the same counter */
+static __thread int size_stripe = -1;
+static volatile int n_size_stripes = 0;
+
+static void hash_list_count(hash_list_t *p_hash_list, long delta)
+{
+	if (size_stripe < 0) {
+		size_stripe = __sync_fetch_and_add(&n_size_stripes, 1) % SIZE_STRIPES;
+	}
+	__sync_fetch_and_add(&p_hash_list->sizes[size_stripe].count, delta);
+}
+
+/* Starts moving the keys to a table of twice the buckets once the
+ * average chain is longer than the load factor. Only called when an
+ * add made its chain long, so the stripes are rarely summed. */
+static void hash_list_check_resize(hash_list_t *p_hash_list)
+{
+	int i;
+	long size = 0;
+	table_t *p_table, *p_new_table;
+
+	if (pthread_mutex_trylock(&p_hash_list->resize_lock) != 0) {
+		return;
+	}
+
+	p_table = p_hash_list->p_table;
+	if (p_table->p_next == NULL && p_table->n_buckets * 2 <= MAX_BUCKETS) {
+		for (i = 0; i < SIZE_STRIPES; i++) {
+			size += p_hash_list->sizes[i].count;
+		}
 
-	for (i = 0; i < p_hash_list->n_buckets; i++) {
-		list_print(p_hash_list->buckets[i]);
+		if (size > (long)p_table->n_buckets * p_hash_list->load_factor) {
+			p_new_table = new_table(p_table->n_buckets * 2, p_table->hash_type);
+			STORE_RELEASE(p_table->p_next, p_new_table);
+		}
 	}
+
+	pthread_mutex_unlock(&p_hash_list->resize_lock);
+}
+
+/* Splits bucket hash of the table into buckets hash and hash + n of the
+ * next table. The new buckets are unused until the bucket is marked as
+ * migrated, and the version makes the readers of the old bucket retry. */
+static void migrate_bucket(table_t *p_table, int hash)
+{
+	list_t *p_list = p_table->buckets[hash];
+	list_t *p_low, *p_high;
+	node_t *p_node, *p_next, *p_max_node;
+	node_t *p_low_last, *p_low_max, *p_high_last, *p_high_max;
+	table_t *p_next_table = p_table->p_next;
+
+	p_low = pure_new_list();
+	p_high = pure_new_list();
+	p_low_last = p_low->p_head;
+	p_low_max = p_low_last->p_next;
+	p_high_last = p_high->p_head;
+	p_high_max = p_high_last->p_next;
+
+	pthread_spin_lock(&p_list->lock);
+	STORE_RELAXED(p_list->version, p_list->version + 1);
+	FENCE_RELEASE();
+
+	p_node = p_list->p_head->p_next;
+	while (p_node->p_next != NULL) {
+		p_next = p_node->p_next;
+		if (HASH_VALUE(p_next_table, p_node->val) == hash) {
+			p_low_last->p_next = p_node;
+			p_low_last = p_node;
+			p_low->size++;
+		} else {
+			p_high_last->p_next = p_node;
+			p_high_last = p_node;
+			p_high->size++;
+		}
+		p_node = p_next;
+	}
+	p_max_node = p_node;
+
+	p_low_last->p_next = p_low_max;
+	p_high_last->p_next = p_high_max;
+	p_next_table->buckets[hash] = p_low;
+	p_next_table->buckets[hash + p_table->n_buckets] = p_high;
+
+	STORE_RELAXED(p_list->p_head->p_next, p_max_node);
+	p_list->size = 0;
+	STORE_RELEASE(p_list->migrated, 1);
+	STORE_RELEASE(p_list->version, p_list->version + 1);
+	pthread_spin_unlock(&p_list->lock);
 }
 
+/* Moves a few buckets of a resizing table. The thread that moves the
+ * last one makes the new table the current one. */
+static void hash_list_help_resize(hash_list_t *p_hash_list)
+{
+	int hash, first, moved = 0;
+	table_t *p_table = LOAD_ACQUIRE(p_hash_list->p_table);
+
+	if (LOAD_ACQUIRE(p_table->p_next) == NULL || p_table->migrate_next >= p_table->n_buckets) {
+		return;
+	}
+
+	first = __sync_fetch_and_add(&p_table->migrate_next, MIGRATE_STEP);
+	for (hash = first; hash < first + MIGRATE_STEP && hash < p_table->n_buckets; hash++) {
+		migrate_bucket(p_table, hash);
+		moved++;
+	}
+
+	if (moved > 0 && __sync_add_and_fetch(&p_table->n_migrated, moved) == p_table->n_buckets) {
+		p_table->p_next->p_retired = p_table;
+		STORE_RELEASE(p_hash_list->p_table, p_table->p_next);
+	}
+}
 
 /////////////////////////////////////////////////////////
 // LIST CONTAINS
 /////////////////////////////////////////////////////////
+/* Walks the bucket without its lock. Adds publish a complete node
+ * with one store, so a walk that only races with adds is valid.
+ * A remove makes the version odd while it unlinks its node, and a
+ * walk that overlapped one may have followed a reused node, so it
+ * starts again. Returns BUCKET_MIGRATED if the bucket moved. */
 int pure_list_contains(list_t *p_list, val_t val) {
-	pthread_spin_lock(&p_list->lock);
-
+	unsigned long version;
 	node_t *p_prev, *p_next;
+	int result;
+
+retry:
+	version = LOAD_ACQUIRE(p_list->version);
+	if (version & 1) {
+		CPU_RELAX();
+		goto retry;
+	}
+	/* Read after the version, a move that ends before the walk is seen here */
+	if (LOAD_ACQUIRE(p_list->migrated)) {
+		return BUCKET_MIGRATED;
+	}
 
 	p_prev = p_list->p_head;
-	p_next = p_prev->p_next;
-	while (p_next->val < val) {
+	p_next = LOAD_ACQUIRE(p_prev->p_next);
+	/* A node in a thread's cache ends in NULL instead of the tail */
+	while (p_next != NULL && p_next->val < val) {
 		p_prev = p_next;
-		p_next = p_prev->p_next;
+		p_next = LOAD_ACQUIRE(p_prev->p_next);
 	}
-	pthread_spin_unlock(&p_list->lock);
-	return p_next->val == val;
+	result = (p_next != NULL && p_next->val == val);
+
+	FENCE_ACQUIRE();
+	if (LOAD_RELAXED(p_list->version) != version) {
+		goto retry;
+	}
+	return result;
 }
 
 /////////////////////////////////////////////////////////
@@ -175,9 +585,13 @@ int pure_list_contains(list_t *p_list, val_t val) {
 /////////////////////////////////////////////////////////
 int pure_hash_list_contains(hash_list_t *p_hash_list, val_t val)
 {
-	int hash = HASH_VALUE(p_hash_list, val);
+	int result;
+	table_t *p_table = LOAD_ACQUIRE(p_hash_list->p_table);
 
-	return pure_list_contains(p_hash_list->buckets[hash], val);
+	while ((result = pure_list_contains(p_table->buckets[HASH_VALUE(p_table, val)], val)) == BUCKET_MIGRATED) {
+		p_table = LOAD_ACQUIRE(p_table->p_next);
+	}
+	return result;
 }
 
 /////////////////////////////////////////////////////////
@@ -190,6 +604,11 @@ int pure_list_add(list_t *p_list, val_t val)
 	int result;
 	node_t *p_prev, *p_next, *p_new_node;
 
+	if (p_list->migrated) {
+		pthread_spin_unlock(&p_list->lock);
+		return BUCKET_MIGRATED;
+	}
+
 	p_prev = p_list->p_head;
 	p_next = p_prev->p_next;
 	while (p_next->val < val) {
@@ -204,7 +623,8 @@ int pure_list_add(list_t *p_list, val_t val)
 		p_new_node->val = val;
 		p_new_node->p_next = p_next;
 
-		p_prev->p_next = p_new_node;
+		STORE_RELEASE(p_prev->p_next, p_new_node);
+		p_list->size++;
 	}
 	pthread_spin_unlock(&p_list->lock);
 	return result;
@@ -216,9 +636,29 @@ int pure_list_add(list_t *p_list, val_t val)
 /////////////////////////////////////////////////////////
 int pure_hash_list_add(hash_list_t *p_hash_list, val_t val)
 {
-	int hash = HASH_VALUE(p_hash_list, val);
+	int result;
+	list_t *p_list;
+	table_t *p_table = LOAD_ACQUIRE(p_hash_list->p_table);
+
+	while (1) {
+		p_list = p_table->buckets[HASH_VALUE(p_table, val)];
+		result = pure_list_add(p_list, val);
+		if (result != BUCKET_MIGRATED) {
+			break;
+		}
+		p_table = LOAD_ACQUIRE(p_table->p_next);
+	}
 
-	return pure_list_add(p_hash_list->buckets[hash], val);
+	if (p_hash_list->load_factor > 0) {
+		if (result) {
+			hash_list_count(p_hash_list, 1);
+			if (p_list->size > 2 * p_hash_list->load_factor) {
+				hash_list_check_resize(p_hash_list);
+			}
+		}
+		hash_list_help_resize(p_hash_list);
+	}
+	return result;
 }
 
 /////////////////////////////////////////////////////////
@@ -230,6 +670,11 @@ int pure_list_remove(list_t *p_list, val_t val) {
 	int result;
 	node_t *p_prev, *p_next;
 
+	if (p_list->migrated) {
+		pthread_spin_unlock(&p_list->lock);
+		return BUCKET_MIGRATED;
+	}
+
 	p_prev = p_list->p_head;
 	p_next = p_prev->p_next;
 	while (p_next->val < val) {
@@ -240,8 +685,12 @@ int pure_list_remove(list_t *p_list, val_t val) {
 	result = (p_next->val == val);
 
 	if (result) {
-		p_prev->p_next = p_next->p_next;
+		STORE_RELAXED(p_list->version, p_list->version + 1);
+		FENCE_RELEASE();
+		STORE_RELAXED(p_prev->p_next, p_next->p_next);
+		STORE_RELEASE(p_list->version, p_list->version + 1);
 		pure_free_node(p_next);
+		p_list->size--;
 	}
 	pthread_spin_unlock(&p_list->lock);
 	return result;
@@ -253,7 +702,315 @@ int pure_list_remove(list_t *p_list, val_t val) {
 /////////////////////////////////////////////////////////
 int pure_hash_list_remove(hash_list_t *p_hash_list, val_t val)
 {
-	int hash = HASH_VALUE(p_hash_list, val);
+	int result;
+	table_t *p_table = LOAD_ACQUIRE(p_hash_list->p_table);
+
+	while ((result = pure_list_remove(p_table->buckets[HASH_VALUE(p_table, val)], val)) == BUCKET_MIGRATED) {
+		p_table = LOAD_ACQUIRE(p_table->p_next);
+	}
+
+	if (p_hash_list->load_factor > 0) {
+		if (result) {
+			hash_list_count(p_hash_list, -1);
+		}
+		hash_list_help_resize(p_hash_list);
+	}
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RCU LIST CONTAINS
+/////////////////////////////////////////////////////////
+/* The RCU lists share the layout of the pure ones. Readers walk a
+ * bucket inside a read side section, writers take the bucket lock and
+ * free a removed node only after a grace period. */
+int rcu_list_contains(list_t *p_list, val_t val) {
+	int result;
+	node_t *p_prev, *p_next;
+
+	rcu_reader_lock();
+
+	p_prev = p_list->p_head;
+	p_next = LOAD_ACQUIRE(p_prev->p_next);
+	while (p_next->val < val) {
+		p_prev = p_next;
+		p_next = LOAD_ACQUIRE(p_prev->p_next);
+	}
+	result = (p_next->val == val);
+
+	rcu_reader_unlock();
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RCU HASH LIST CONTAINS
+/////////////////////////////////////////////////////////
+int rcu_hash_list_contains(hash_list_t *p_hash_list, val_t val)
+{
+	table_t *p_table = p_hash_list->p_table;
+	int hash = HASH_VALUE(p_table, val);
+
+	return rcu_list_contains(p_table->buckets[hash], val);
+}
+
+/////////////////////////////////////////////////////////
+// RCU LIST ADD
+/////////////////////////////////////////////////////////
+int rcu_list_add(list_t *p_list, val_t val)
+{
+	int result;
+	node_t *p_prev, *p_next, *p_new_node;
+
+	pthread_spin_lock(&p_list->lock);
+
+	p_prev = p_list->p_head;
+	p_next = p_prev->p_next;
+	while (p_next->val < val) {
+		p_prev = p_next;
+		p_next = p_prev->p_next;
+	}
+
+	result = (p_next->val != val);
+
+	if (result) {
+		p_new_node = pure_new_node();
+		p_new_node->val = val;
+		p_new_node->p_next = p_next;
+
+		STORE_RELEASE(p_prev->p_next, p_new_node);
+	}
+	pthread_spin_unlock(&p_list->lock);
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RCU HASH LIST ADD
+/////////////////////////////////////////////////////////
+int rcu_hash_list_add(hash_list_t *p_hash_list, val_t val)
+{
+	table_t *p_table = p_hash_list->p_table;
+	int hash = HASH_VALUE(p_table, val);
+
+	return rcu_list_add(p_table->buckets[hash], val);
+}
+
+/////////////////////////////////////////////////////////
+// RCU LIST REMOVE
+/////////////////////////////////////////////////////////
+int rcu_list_remove(list_t *p_list, val_t val)
+{
+	int result;
+	node_t *p_prev, *p_next;
+
+	pthread_spin_lock(&p_list->lock);
+
+	p_prev = p_list->p_head;
+	p_next = p_prev->p_next;
+	while (p_next->val < val) {
+		p_prev = p_next;
+		p_next = p_prev->p_next;
+	}
+
+	result = (p_next->val == val);
+
+	if (result) {
+		/* Readers on the node still find its successor */
+		STORE_RELEASE(p_prev->p_next, p_next->p_next);
+	}
+	pthread_spin_unlock(&p_list->lock);
+
+	if (result) {
+		rcu_free(p_next);
+	}
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RCU HASH LIST REMOVE
+/////////////////////////////////////////////////////////
+int rcu_hash_list_remove(hash_list_t *p_hash_list, val_t val)
+{
+	table_t *p_table = p_hash_list->p_table;
+	int hash = HASH_VALUE(p_table, val);
+
+	return rcu_list_remove(p_table->buckets[hash], val);
+}
+
+/////////////////////////////////////////////////////////
+// RLU NEW LIST
+/////////////////////////////////////////////////////////
+/* The MV-RLU lists hold their nodes in MV-RLU objects. Operations
+ * read a snapshot through rlu_deref and write private copies of the
+ * nodes they lock, which their commit publishes. */
+list_t *rlu_new_list()
+{
+	list_t *p_list;
+	node_t *p_min_node, *p_max_node;
+
+	p_list = (list_t *)malloc(sizeof(list_t));
+	if (p_list == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	pthread_spin_init(&p_list->lock, 0);
+	p_list->version = 0;
+	p_list->migrated = 0;
+	p_list->size = 0;
+
+	p_max_node = (node_t *)rlu_alloc(sizeof(node_t));
+	p_max_node->val = LIST_VAL_MAX;
+	p_max_node->p_next = NULL;
+
+	p_min_node = (node_t *)rlu_alloc(sizeof(node_t));
+	p_min_node->val = LIST_VAL_MIN;
+	p_min_node->p_next = p_max_node;
+
+	p_list->p_head = p_min_node;
+
+	return p_list;
+}
+
+/////////////////////////////////////////////////////////
+// RLU NEW HASH LIST
+/////////////////////////////////////////////////////////
+hash_list_t *rlu_new_hash_list(int n_buckets, int hash_type)
+{
+	int i;
+	table_t *p_table;
+
+	n_buckets = round_buckets(n_buckets);
+	p_table = new_table(n_buckets, hash_type);
+	for (i = 0; i < n_buckets; i++) {
+		p_table->buckets[i] = rlu_new_list();
+	}
+
+	/* The buckets are never moved, copies of them are not followed */
+	return new_hash_list(p_table, 0);
+}
+
+/////////////////////////////////////////////////////////
+// RLU LIST CONTAINS
+/////////////////////////////////////////////////////////
+int rlu_list_contains(rlu_thread_data_t *self, list_t *p_list, val_t val) {
+	int result;
+	node_t *p_prev, *p_next;
+
+	rlu_reader_lock(self);
+
+	p_prev = (node_t *)rlu_deref(self, p_list->p_head);
+	p_next = (node_t *)rlu_deref(self, p_prev->p_next);
+	while (p_next->val < val) {
+		p_prev = p_next;
+		p_next = (node_t *)rlu_deref(self, p_prev->p_next);
+	}
+	result = (p_next->val == val);
+
+	rlu_reader_unlock(self);
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RLU HASH LIST CONTAINS
+/////////////////////////////////////////////////////////
+int rlu_hash_list_contains(rlu_thread_data_t *self, hash_list_t *p_hash_list, val_t val)
+{
+	table_t *p_table = p_hash_list->p_table;
+	int hash = HASH_VALUE(p_table, val);
+
+	return rlu_list_contains(self, p_table->buckets[hash], val);
+}
+
+/////////////////////////////////////////////////////////
+// RLU LIST ADD
+/////////////////////////////////////////////////////////
+/* Locking the predecessor is enough: a remove of the successor locks
+ * it too, so either one fails its try lock and restarts */
+int rlu_list_add(rlu_thread_data_t *self, list_t *p_list, val_t val)
+{
+	int result;
+	node_t *p_prev, *p_next, *p_new_node;
+
+restart:
+	rlu_reader_lock(self);
+
+	p_prev = (node_t *)rlu_deref(self, p_list->p_head);
+	p_next = (node_t *)rlu_deref(self, p_prev->p_next);
+	while (p_next->val < val) {
+		p_prev = p_next;
+		p_next = (node_t *)rlu_deref(self, p_prev->p_next);
+	}
+
+	result = (p_next->val != val);
+
+	if (result) {
+		if (!rlu_try_lock(self, (void **)&p_prev)) {
+			rlu_abort(self);
+			goto restart;
+		}
+
+		p_new_node = (node_t *)rlu_alloc(sizeof(node_t));
+		p_new_node->val = val;
+		rlu_assign_ptr((void **)&p_new_node->p_next, p_next);
+
+		rlu_assign_ptr((void **)&p_prev->p_next, p_new_node);
+	}
+
+	rlu_reader_unlock(self);
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RLU HASH LIST ADD
+/////////////////////////////////////////////////////////
+int rlu_hash_list_add(rlu_thread_data_t *self, hash_list_t *p_hash_list, val_t val)
+{
+	table_t *p_table = p_hash_list->p_table;
+	int hash = HASH_VALUE(p_table, val);
+
+	return rlu_list_add(self, p_table->buckets[hash], val);
+}
+
+/////////////////////////////////////////////////////////
+// RLU LIST REMOVE
+/////////////////////////////////////////////////////////
+int rlu_list_remove(rlu_thread_data_t *self, list_t *p_list, val_t val)
+{
+	int result;
+	node_t *p_prev, *p_next;
+
+restart:
+	rlu_reader_lock(self);
+
+	p_prev = (node_t *)rlu_deref(self, p_list->p_head);
+	p_next = (node_t *)rlu_deref(self, p_prev->p_next);
+	while (p_next->val < val) {
+		p_prev = p_next;
+		p_next = (node_t *)rlu_deref(self, p_prev->p_next);
+	}
+
+	result = (p_next->val == val);
+
+	if (result) {
+		if (!rlu_try_lock(self, (void **)&p_prev) || !rlu_try_lock(self, (void **)&p_next)) {
+			rlu_abort(self);
+			goto restart;
+		}
+
+		rlu_assign_ptr((void **)&p_prev->p_next, p_next->p_next);
+		rlu_free(self, p_next);
+	}
+
+	rlu_reader_unlock(self);
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// RLU HASH LIST REMOVE
+/////////////////////////////////////////////////////////
+int rlu_hash_list_remove(rlu_thread_data_t *self, hash_list_t *p_hash_list, val_t val)
+{
+	table_t *p_table = p_hash_list->p_table;
+	int hash = HASH_VALUE(p_table, val);
 
-	return pure_list_remove(p_hash_list->buckets[hash], val);
+	return rlu_list_remove(self, p_table->buckets[hash], val);
 }
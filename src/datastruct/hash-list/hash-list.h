@@ -5,18 +5,33 @@
 // INCLUDES
 /////////////////////////////////////////////////////////
 #include "types.h"
+#include "mvrlu.h"
 
 
 /////////////////////////////////////////////////////////
 // INTERFACE
 /////////////////////////////////////////////////////////
-hash_list_t *pure_new_hash_list(int n_buckets);
+int hash_type_supported(int hash_type);
+
+hash_list_t *pure_new_hash_list(int n_buckets, int load_factor, int hash_type);
 
 int hash_list_size(hash_list_t *p_hash_list);
+int hash_list_buckets(hash_list_t *p_hash_list);
+int hash_list_chains(hash_list_t *p_hash_list, unsigned long *counts, int n_counts);
 void hash_list_print(hash_list_t *p_hash_list);
 
 int pure_hash_list_contains(hash_list_t *p_hash_list, val_t val);
 int pure_hash_list_add(hash_list_t *p_hash_list, val_t val);
 int pure_hash_list_remove(hash_list_t *p_hash_list, val_t val);
 
+int rcu_hash_list_contains(hash_list_t *p_hash_list, val_t val);
+int rcu_hash_list_add(hash_list_t *p_hash_list, val_t val);
+int rcu_hash_list_remove(hash_list_t *p_hash_list, val_t val);
+
+hash_list_t *rlu_new_hash_list(int n_buckets, int hash_type);
+
+int rlu_hash_list_contains(rlu_thread_data_t *self, hash_list_t *p_hash_list, val_t val);
+int rlu_hash_list_add(rlu_thread_data_t *self, hash_list_t *p_hash_list, val_t val);
+int rlu_hash_list_remove(rlu_thread_data_t *self, hash_list_t *p_hash_list, val_t val);
+
 #endif // _HASH_LIST_H_
@@ -0,0 +1,493 @@
+/////////////////////////////////////////////////////////
+// INCLUDES
+/////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include "mvrlu.h"
+
+/////////////////////////////////////////////////////////
+// DEFINES
+/////////////////////////////////////////////////////////
+/* Pause of the garbage collector between rounds nobody asked for */
+#define RLU_GC_PAUSE_US          (100)
+
+/////////////////////////////////////////////////////////
+// GLOBALS
+/////////////////////////////////////////////////////////
+/* Starts above RLU_CLOCK_ENTERING, so a clock in a section is never mistaken for one of them */
+volatile unsigned long rlu_global_clock = 2;
+
+static rlu_thread_data_t *rlu_threads[RLU_MAX_THREADS];
+static volatile int rlu_n_threads = 0;
+static int rlu_max_ws = RLU_DEFAULT_MAX_WS;
+
+static pthread_t rlu_gc_thread;
+static volatile int rlu_gc_stop = 0;
+static volatile int rlu_gc_requested = 0;
+
+/* Write sets out of every chain, freed once no reader can still hold them. Owned by the collector */
+static rlu_ws_t *p_limbo = NULL;
+static unsigned long n_gc_rounds = 0;
+static unsigned long n_write_backs = 0;
+
+/////////////////////////////////////////////////////////
+// WRITE SETS
+/////////////////////////////////////////////////////////
+static rlu_ws_t *rlu_new_ws() {
+	rlu_ws_t *p_ws = (rlu_ws_t *)malloc(sizeof(rlu_ws_t));
+
+	if (p_ws == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+
+	p_ws->commit_ts = RLU_TS_ACTIVE;
+	p_ws->p_versions = NULL;
+	p_ws->n_frees = 0;
+	p_ws->p_next = NULL;
+	p_ws->free_ts = 0;
+	return p_ws;
+}
+
+static void rlu_reclaim_ws(rlu_ws_t *p_ws) {
+	int i;
+	rlu_version_t *p_version, *p_next;
+
+	for (p_version = p_ws->p_versions; p_version != NULL; p_version = p_next) {
+		p_next = p_version->p_ws_next;
+		free(p_version);
+	}
+	for (i = 0; i < p_ws->n_frees; i++) {
+		free(rlu_header(p_ws->frees[i]));
+	}
+	free(p_ws);
+}
+
+static void rlu_log_append(rlu_thread_data_t *self, rlu_ws_t *p_ws) {
+	p_ws->p_next = NULL;
+
+	pthread_spin_lock(&self->log_lock);
+	if (self->p_log_tail != NULL) {
+		self->p_log_tail->p_next = p_ws;
+	} else {
+		self->p_log_head = p_ws;
+	}
+	self->p_log_tail = p_ws;
+	pthread_spin_unlock(&self->log_lock);
+
+	__sync_fetch_and_add(&self->n_log, 1);
+}
+
+/////////////////////////////////////////////////////////
+// ALLOC / FREE
+/////////////////////////////////////////////////////////
+void *rlu_alloc(size_t size) {
+	rlu_header_t *p_header = (rlu_header_t *)malloc(sizeof(rlu_header_t) + size);
+
+	if (p_header == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+
+	p_header->p_copy = NULL;
+	p_header->p_master = NULL;
+	p_header->wb_ts = 0;
+	p_header->size = size;
+	return p_header + 1;
+}
+
+/* Frees an object the operation locked, once the operation commits and no reader can hold it */
+void rlu_free(rlu_thread_data_t *self, void *p_obj) {
+	if (self->p_ws == NULL || self->p_ws->n_frees == RLU_MAX_FREES) {
+		printf("rlu_free: object not locked or too many frees\n");
+		exit(1);
+	}
+
+	self->p_ws->frees[self->p_ws->n_frees++] = rlu_master(p_obj);
+}
+
+/////////////////////////////////////////////////////////
+// TRY LOCK
+/////////////////////////////////////////////////////////
+/* Pushes a private copy of *pp_obj on its chain and points *pp_obj to
+ * it. Fails if another operation holds the object or committed it
+ * after the thread's clock, the operation must then abort. */
+int rlu_try_lock(rlu_thread_data_t *self, void **pp_obj) {
+	void *p_master = rlu_master(*pp_obj);
+	rlu_header_t *p_header = rlu_header(p_master);
+	rlu_version_t *p_head, *p_version;
+	void *p_src;
+
+	if (self->p_ws == NULL) {
+		self->p_ws = rlu_new_ws();
+	}
+
+	p_head = __atomic_load_n(&p_header->p_copy, __ATOMIC_ACQUIRE);
+	if (p_head != NULL) {
+		if (p_head->p_ws == self->p_ws) {
+			*pp_obj = p_head->data;
+			return 1;
+		}
+		if (__atomic_load_n(&p_head->p_ws->commit_ts, __ATOMIC_ACQUIRE) > self->local_clock) {
+			return 0;
+		}
+		p_src = p_head->data;
+	} else {
+		if (__atomic_load_n(&p_header->wb_ts, __ATOMIC_ACQUIRE) > self->local_clock) {
+			return 0;
+		}
+		p_src = p_master;
+	}
+
+	p_version = (rlu_version_t *)malloc(sizeof(rlu_version_t) + p_header->size);
+	if (p_version == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	p_version->p_ws = self->p_ws;
+	p_version->detached = 0;
+	p_version->header.p_copy = NULL;
+	p_version->header.p_master = p_master;
+	p_version->header.wb_ts = 0;
+	p_version->header.size = p_header->size;
+	memcpy(p_version->data, p_src, p_header->size);
+	p_version->p_older = p_head;
+
+	if (__sync_val_compare_and_swap(&p_header->p_copy, p_head, p_version) != p_head) {
+		free(p_version);
+		return 0;
+	}
+	p_version->p_ws_next = self->p_ws->p_versions;
+	self->p_ws->p_versions = p_version;
+
+	/* The chain was emptied and refilled since the load, a write back
+	 * may have overwritten the object while it was being copied */
+	if (p_head == NULL && __atomic_load_n(&p_header->wb_ts, __ATOMIC_ACQUIRE) > self->local_clock) {
+		return 0;
+	}
+
+	*pp_obj = p_version->data;
+	return 1;
+}
+
+/////////////////////////////////////////////////////////
+// COMMIT / ABORT
+/////////////////////////////////////////////////////////
+/* Ends the section. An operation that locked objects commits: its
+ * copies become visible at once to every reader whose clock is at
+ * least the commit time. */
+void rlu_reader_unlock(rlu_thread_data_t *self) {
+	rlu_ws_t *p_ws = self->p_ws;
+	unsigned long ts;
+
+	if (p_ws != NULL) {
+		/* Readers that find the write set PENDING wait for its time instead of skipping it */
+		__atomic_store_n(&p_ws->commit_ts, RLU_TS_PENDING, __ATOMIC_SEQ_CST);
+		ts = __atomic_add_fetch(&rlu_global_clock, 1, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&p_ws->commit_ts, ts, __ATOMIC_RELEASE);
+
+		rlu_log_append(self, p_ws);
+		self->p_ws = NULL;
+		self->n_commits++;
+	}
+
+	__atomic_store_n(&self->local_clock, RLU_CLOCK_IDLE, __ATOMIC_RELEASE);
+
+	if (p_ws != NULL && self->n_log > rlu_max_ws) {
+		self->n_waits++;
+		while (self->n_log > rlu_max_ws) {
+			rlu_gc_requested = 1;
+			sched_yield();
+		}
+	}
+}
+
+/* Takes the operation's copies off their chains and ends the section, the caller restarts */
+void rlu_abort(rlu_thread_data_t *self) {
+	rlu_ws_t *p_ws = self->p_ws;
+	rlu_version_t *p_version;
+
+	if (p_ws != NULL) {
+		for (p_version = p_ws->p_versions; p_version != NULL; p_version = p_version->p_ws_next) {
+			__atomic_store_n(&rlu_header(p_version->header.p_master)->p_copy,
+				p_version->p_older, __ATOMIC_RELEASE);
+			p_version->detached = 1;
+		}
+		p_ws->n_frees = 0;
+
+		/* Readers may still be on the copies, the collector frees them */
+		rlu_log_append(self, p_ws);
+		self->p_ws = NULL;
+	}
+	self->n_aborts++;
+
+	__atomic_store_n(&self->local_clock, RLU_CLOCK_IDLE, __ATOMIC_RELEASE);
+}
+
+/////////////////////////////////////////////////////////
+// GARBAGE COLLECTION
+/////////////////////////////////////////////////////////
+/* Oldest clock any thread reads at, now or later */
+static unsigned long rlu_min_clock() {
+	int i, n_threads;
+	unsigned long min_clock, clock;
+	rlu_thread_data_t *p_thread;
+
+	min_clock = __atomic_load_n(&rlu_global_clock, __ATOMIC_SEQ_CST);
+	n_threads = __atomic_load_n(&rlu_n_threads, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < n_threads; i++) {
+		p_thread = __atomic_load_n(&rlu_threads[i], __ATOMIC_ACQUIRE);
+		if (p_thread == NULL) {
+			continue;
+		}
+
+		clock = __atomic_load_n(&p_thread->local_clock, __ATOMIC_ACQUIRE);
+		while (clock == RLU_CLOCK_ENTERING) {
+			RLU_CPU_RELAX();
+			clock = __atomic_load_n(&p_thread->local_clock, __ATOMIC_ACQUIRE);
+		}
+		if (clock != RLU_CLOCK_IDLE && clock < min_clock) {
+			min_clock = clock;
+		}
+	}
+	return min_clock;
+}
+
+/* Writes the newest copy committed at or before min_clock back into
+ * the object and cuts it and the older copies off the chain. No reader
+ * reads the object meanwhile, as every reader stops at that copy or a
+ * newer one. Returns 0 if an uncommitted copy points to it, to be
+ * retried in a later round. */
+static int rlu_write_back(void *p_master, unsigned long min_clock) {
+	rlu_header_t *p_header = rlu_header(p_master);
+	rlu_version_t *p_version, *p_newer = NULL;
+	unsigned long ts = 0;
+
+	p_version = __atomic_load_n(&p_header->p_copy, __ATOMIC_ACQUIRE);
+	while (p_version != NULL) {
+		ts = __atomic_load_n(&p_version->p_ws->commit_ts, __ATOMIC_ACQUIRE);
+		if (ts <= min_clock) {
+			break;
+		}
+		p_newer = p_version;
+		p_version = p_version->p_older;
+	}
+
+	if (p_version == NULL) {
+		return 1;
+	}
+	if (p_newer != NULL && __atomic_load_n(&p_newer->p_ws->commit_ts, __ATOMIC_ACQUIRE) >= RLU_TS_PENDING) {
+		return 0;
+	}
+
+	__atomic_store_n(&p_header->wb_ts, ts, __ATOMIC_SEQ_CST);
+	memcpy(p_master, p_version->data, p_header->size);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	if (p_newer == NULL) {
+		if (__sync_val_compare_and_swap(&p_header->p_copy, p_version, NULL) != p_version) {
+			return 0;
+		}
+	} else {
+		__atomic_store_n(&p_newer->p_older, NULL, __ATOMIC_RELEASE);
+	}
+
+	n_write_backs++;
+	for (; p_version != NULL; p_version = p_version->p_older) {
+		p_version->detached = 1;
+	}
+	return 1;
+}
+
+/* Returns 1 once none of the write set's copies is on a chain */
+static int rlu_collect_ws(rlu_ws_t *p_ws, unsigned long min_clock) {
+	int collected = 1;
+	rlu_version_t *p_version;
+
+	if (p_ws->commit_ts == RLU_TS_ACTIVE) {
+		/* Aborted */
+		return 1;
+	}
+	if (p_ws->commit_ts > min_clock) {
+		return 0;
+	}
+
+	for (p_version = p_ws->p_versions; p_version != NULL; p_version = p_version->p_ws_next) {
+		if (!p_version->detached && !rlu_write_back(p_version->header.p_master, min_clock)) {
+			collected = 0;
+		}
+	}
+	return collected;
+}
+
+static void rlu_collect_log(rlu_thread_data_t *p_thread, unsigned long min_clock, rlu_ws_t **pp_collected) {
+	long n_collected = 0;
+	rlu_ws_t *p_ws, *p_next, *p_keep_head = NULL, *p_keep_tail = NULL;
+
+	pthread_spin_lock(&p_thread->log_lock);
+	p_ws = p_thread->p_log_head;
+	p_thread->p_log_head = NULL;
+	p_thread->p_log_tail = NULL;
+	pthread_spin_unlock(&p_thread->log_lock);
+
+	for (; p_ws != NULL; p_ws = p_next) {
+		p_next = p_ws->p_next;
+		if (rlu_collect_ws(p_ws, min_clock)) {
+			p_ws->p_next = *pp_collected;
+			*pp_collected = p_ws;
+			n_collected++;
+		} else {
+			p_ws->p_next = NULL;
+			if (p_keep_tail != NULL) {
+				p_keep_tail->p_next = p_ws;
+			} else {
+				p_keep_head = p_ws;
+			}
+			p_keep_tail = p_ws;
+		}
+	}
+
+	/* The write sets kept go back in front of the ones committed meanwhile */
+	if (p_keep_head != NULL) {
+		pthread_spin_lock(&p_thread->log_lock);
+		p_keep_tail->p_next = p_thread->p_log_head;
+		if (p_thread->p_log_head == NULL) {
+			p_thread->p_log_tail = p_keep_tail;
+		}
+		p_thread->p_log_head = p_keep_head;
+		pthread_spin_unlock(&p_thread->log_lock);
+	}
+
+	__sync_fetch_and_sub(&p_thread->n_log, n_collected);
+}
+
+/* Writes back every write set older than all readers, and frees the
+ * write sets cut off in earlier rounds that no reader can hold anymore */
+static int rlu_gc_round() {
+	int i, n_threads, pending = 0;
+	unsigned long min_clock, now;
+	rlu_ws_t *p_collected = NULL, *p_ws, *p_next, *p_keep = NULL;
+	rlu_thread_data_t *p_thread;
+
+	min_clock = rlu_min_clock();
+
+	for (p_ws = p_limbo; p_ws != NULL; p_ws = p_next) {
+		p_next = p_ws->p_next;
+		if (p_ws->free_ts < min_clock) {
+			rlu_reclaim_ws(p_ws);
+		} else {
+			p_ws->p_next = p_keep;
+			p_keep = p_ws;
+			pending = 1;
+		}
+	}
+	p_limbo = p_keep;
+
+	n_threads = __atomic_load_n(&rlu_n_threads, __ATOMIC_ACQUIRE);
+	for (i = 0; i < n_threads; i++) {
+		p_thread = __atomic_load_n(&rlu_threads[i], __ATOMIC_ACQUIRE);
+		if (p_thread != NULL) {
+			rlu_collect_log(p_thread, min_clock, &p_collected);
+			pending |= (p_thread->n_log > 0);
+		}
+	}
+
+	/* Readers that start after the increment cannot reach the write sets collected above */
+	now = __atomic_fetch_add(&rlu_global_clock, 1, __ATOMIC_SEQ_CST);
+	for (p_ws = p_collected; p_ws != NULL; p_ws = p_next) {
+		p_next = p_ws->p_next;
+		p_ws->free_ts = now;
+		p_ws->p_next = p_limbo;
+		p_limbo = p_ws;
+		pending = 1;
+	}
+
+	n_gc_rounds++;
+	return pending;
+}
+
+static void *rlu_gc_main(void *arg) {
+	while (!rlu_gc_stop) {
+		rlu_gc_round();
+		if (!rlu_gc_requested) {
+			usleep(RLU_GC_PAUSE_US);
+		}
+		rlu_gc_requested = 0;
+	}
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////
+// INIT / FINISH
+/////////////////////////////////////////////////////////
+/* max_ws bounds the write sets a thread has waiting for the collector, a commit past it waits */
+void rlu_init(int max_ws) {
+	if (max_ws > 0) {
+		rlu_max_ws = max_ws;
+	}
+
+	rlu_gc_stop = 0;
+	if (pthread_create(&rlu_gc_thread, NULL, rlu_gc_main, NULL) != 0) {
+		fprintf(stderr, "Error creating the garbage collector thread\n");
+		exit(1);
+	}
+}
+
+/* Stops the collector and writes every copy back, so the objects hold
+ * the latest data. Every thread must be outside of its section. */
+void rlu_finish() {
+	rlu_gc_stop = 1;
+	pthread_join(rlu_gc_thread, NULL);
+
+	while (rlu_gc_round()) {
+	}
+}
+
+void rlu_thread_init(rlu_thread_data_t *self) {
+	int id;
+
+	self->local_clock = RLU_CLOCK_IDLE;
+	self->p_ws = NULL;
+	pthread_spin_init(&self->log_lock, PTHREAD_PROCESS_PRIVATE);
+	self->p_log_head = NULL;
+	self->p_log_tail = NULL;
+	self->n_log = 0;
+	self->n_commits = 0;
+	self->n_aborts = 0;
+	self->n_waits = 0;
+
+	id = __sync_fetch_and_add(&rlu_n_threads, 1);
+	if (id >= RLU_MAX_THREADS) {
+		printf("rlu: more than %d threads\n", RLU_MAX_THREADS);
+		exit(1);
+	}
+	__atomic_store_n(&rlu_threads[id], self, __ATOMIC_RELEASE);
+}
+
+/* The thread's log stays registered, the collector still empties it */
+void rlu_thread_finish(rlu_thread_data_t *self) {
+	__atomic_store_n(&self->local_clock, RLU_CLOCK_IDLE, __ATOMIC_RELEASE);
+}
+
+void rlu_print_stats() {
+	int i;
+	unsigned long n_commits = 0, n_aborts = 0, n_waits = 0;
+
+	for (i = 0; i < rlu_n_threads; i++) {
+		if (rlu_threads[i] != NULL) {
+			n_commits += rlu_threads[i]->n_commits;
+			n_aborts += rlu_threads[i]->n_aborts;
+			n_waits += rlu_threads[i]->n_waits;
+		}
+	}
+
+	printf("MV-RLU commits   : %lu\n", n_commits);
+	printf("MV-RLU aborts    : %lu\n", n_aborts);
+	printf("MV-RLU ws waits  : %lu\n", n_waits);
+	printf("MV-RLU gc rounds : %lu\n", n_gc_rounds);
+	printf("MV-RLU writebacks: %lu\n", n_write_backs);
+}
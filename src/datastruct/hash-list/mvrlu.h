@@ -0,0 +1,166 @@
+#ifndef _MVRLU_H_
+#define _MVRLU_H_
+
+/////////////////////////////////////////////////////////
+// INCLUDES
+/////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <pthread.h>
+
+/////////////////////////////////////////////////////////
+// DEFINES
+/////////////////////////////////////////////////////////
+#define RLU_MAX_THREADS         (512)
+/* Objects one operation can free */
+#define RLU_MAX_FREES           (16)
+#define RLU_CACHE_LINE          (64)
+#define RLU_DEFAULT_MAX_WS      (64)
+
+/* Values of a thread's clock outside of a section, and while it enters one */
+#define RLU_CLOCK_IDLE          (0UL)
+#define RLU_CLOCK_ENTERING      (1UL)
+
+/* Commit times of a write set that is not committed, and of one that is committing */
+#define RLU_TS_ACTIVE           (~0UL)
+#define RLU_TS_PENDING          (~0UL - 1)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RLU_CPU_RELAX()         __asm__ __volatile__("pause" ::: "memory")
+#else
+#define RLU_CPU_RELAX()         __asm__ __volatile__("" ::: "memory")
+#endif
+
+/////////////////////////////////////////////////////////
+// TYPES
+/////////////////////////////////////////////////////////
+struct rlu_version;
+
+/* Precedes every object and every copy of one */
+typedef struct rlu_header {
+	/* Objects: newest copy or NULL. Copies: unused */
+	struct rlu_version *volatile p_copy;
+	/* Objects: NULL. Copies: the object */
+	void *p_master;
+	/* Objects: commit time of the copy last written back into them */
+	volatile unsigned long wb_ts;
+	size_t size;
+} rlu_header_t;
+
+/* Writes of one operation, visible to the readers whose clock is at least commit_ts */
+typedef struct rlu_ws {
+	volatile unsigned long commit_ts;
+	struct rlu_version *p_versions;
+	int n_frees;
+	void *frees[RLU_MAX_FREES];
+	/* Next write set in the thread's log, or in the garbage collector's limbo */
+	struct rlu_ws *p_next;
+	unsigned long free_ts;
+} rlu_ws_t;
+
+/* A copy of an object, linked from the object newest first */
+typedef struct rlu_version {
+	struct rlu_version *volatile p_older;
+	rlu_ws_t *p_ws;
+	/* Next copy of the same write set */
+	struct rlu_version *p_ws_next;
+	/* Set by the garbage collector or an abort once the copy is out of its chain */
+	int detached;
+	rlu_header_t header;
+	char data[];
+} rlu_version_t;
+
+typedef struct rlu_thread_data {
+	/* Global clock when the thread entered its section, the snapshot it reads */
+	volatile unsigned long local_clock;
+	/* Write set of the current operation, NULL until it locks an object */
+	rlu_ws_t *p_ws;
+
+	/* Committed and aborted write sets the garbage collector has not reclaimed yet */
+	pthread_spinlock_t log_lock;
+	rlu_ws_t *p_log_head;
+	rlu_ws_t *p_log_tail;
+	volatile long n_log;
+
+	unsigned long n_commits;
+	unsigned long n_aborts;
+	unsigned long n_waits;
+	char padding[RLU_CACHE_LINE];
+} __attribute__((aligned(RLU_CACHE_LINE))) rlu_thread_data_t;
+
+extern volatile unsigned long rlu_global_clock;
+
+/////////////////////////////////////////////////////////
+// INTERFACE
+/////////////////////////////////////////////////////////
+void rlu_init(int max_ws);
+void rlu_finish();
+void rlu_print_stats();
+
+void rlu_thread_init(rlu_thread_data_t *self);
+void rlu_thread_finish(rlu_thread_data_t *self);
+
+void rlu_reader_unlock(rlu_thread_data_t *self);
+int rlu_try_lock(rlu_thread_data_t *self, void **pp_obj);
+void rlu_abort(rlu_thread_data_t *self);
+
+void *rlu_alloc(size_t size);
+void rlu_free(rlu_thread_data_t *self, void *p_obj);
+
+static inline rlu_header_t *rlu_header(void *p_obj) {
+	return ((rlu_header_t *)p_obj) - 1;
+}
+
+/* Object of p_obj, which may be the object or a copy of it */
+static inline void *rlu_master(void *p_obj) {
+	void *p_master = rlu_header(p_obj)->p_master;
+
+	return p_master != NULL ? p_master : p_obj;
+}
+
+/* A garbage collector that finds the clock ENTERING waits for the real
+ * value, which is read after the fence and so covers every write back
+ * the collector could have started without seeing the thread. */
+static inline void rlu_reader_lock(rlu_thread_data_t *self) {
+	__atomic_store_n(&self->local_clock, RLU_CLOCK_ENTERING, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	__atomic_store_n(&self->local_clock,
+		__atomic_load_n(&rlu_global_clock, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+	self->p_ws = NULL;
+}
+
+/* Returns the copy of p_obj the thread reads: its own uncommitted copy,
+ * else the newest copy committed at or before its clock, else the object */
+static inline void *rlu_deref(rlu_thread_data_t *self, void *p_obj) {
+	rlu_version_t *p_version;
+	unsigned long ts;
+
+	if (p_obj == NULL || rlu_header(p_obj)->p_master != NULL) {
+		return p_obj;
+	}
+
+	p_version = __atomic_load_n(&rlu_header(p_obj)->p_copy, __ATOMIC_ACQUIRE);
+	while (p_version != NULL) {
+		if (p_version->p_ws == self->p_ws) {
+			return p_version->data;
+		}
+
+		ts = __atomic_load_n(&p_version->p_ws->commit_ts, __ATOMIC_ACQUIRE);
+		while (ts == RLU_TS_PENDING) {
+			RLU_CPU_RELAX();
+			ts = __atomic_load_n(&p_version->p_ws->commit_ts, __ATOMIC_ACQUIRE);
+		}
+		if (ts <= self->local_clock) {
+			return p_version->data;
+		}
+
+		p_version = __atomic_load_n(&p_version->p_older, __ATOMIC_ACQUIRE);
+	}
+	return p_obj;
+}
+
+/* Stores a reference to the object of p_obj, copies are never referenced */
+static inline void rlu_assign_ptr(void **pp_ptr, void *p_obj) {
+	*pp_ptr = p_obj != NULL ? rlu_master(p_obj) : NULL;
+}
+
+#endif // _MVRLU_H_
@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////
+// INCLUDES
+/////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+#include "rcu.h"
+
+/////////////////////////////////////////////////////////
+// DEFINES
+/////////////////////////////////////////////////////////
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX()              __asm__ __volatile__("pause" ::: "memory")
+#else
+#define CPU_RELAX()              __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* Pauses a waiting thread spins before it yields to the reader it waits for */
+#define RCU_SPINS               (1000)
+
+/////////////////////////////////////////////////////////
+// GLOBALS
+/////////////////////////////////////////////////////////
+rcu_thread_t rcu_threads[RCU_MAX_THREADS];
+/* Starts at 1 so that a thread inside a section never reads as 0 */
+volatile unsigned long rcu_global_time = 1;
+__thread int rcu_thread_id;
+
+static volatile int rcu_n_threads = 0;
+
+static __thread void *rcu_free_ptrs[RCU_MAX_FREE];
+static __thread int rcu_n_free = 0;
+
+/////////////////////////////////////////////////////////
+// REGISTER
+/////////////////////////////////////////////////////////
+void rcu_register(int id) {
+	int n_threads;
+
+	if (id < 0 || id >= RCU_MAX_THREADS) {
+		printf("rcu: thread id %d out of range\n", id);
+		exit(1);
+	}
+
+	rcu_thread_id = id;
+	rcu_threads[id].time = 0;
+
+	n_threads = rcu_n_threads;
+	while (n_threads <= id) {
+		n_threads = __sync_val_compare_and_swap(&rcu_n_threads, n_threads, id + 1);
+	}
+}
+
+/////////////////////////////////////////////////////////
+// FLUSH FREES
+/////////////////////////////////////////////////////////
+static void rcu_flush_frees() {
+	int i;
+
+	rcu_synchronize();
+
+	for (i = 0; i < rcu_n_free; i++) {
+		free(rcu_free_ptrs[i]);
+	}
+	rcu_n_free = 0;
+}
+
+void rcu_unregister() {
+	rcu_flush_frees();
+}
+
+/////////////////////////////////////////////////////////
+// SYNCHRONIZE
+/////////////////////////////////////////////////////////
+/* Waits until every read side section that started before the call
+ * has ended. Must be called outside of a read side section. */
+void rcu_synchronize() {
+	int i, n_threads, spins;
+	unsigned long now, time;
+
+	now = __atomic_add_fetch(&rcu_global_time, 1, __ATOMIC_SEQ_CST);
+	n_threads = __atomic_load_n(&rcu_n_threads, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < n_threads; i++) {
+		spins = 0;
+		while (1) {
+			time = __atomic_load_n(&rcu_threads[i].time, __ATOMIC_ACQUIRE);
+			if (time == 0 || time >= now) {
+				break;
+			}
+			if (++spins < RCU_SPINS) {
+				CPU_RELAX();
+			} else {
+				sched_yield();
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+// FREE
+/////////////////////////////////////////////////////////
+/* Frees ptr once no reader can hold it. Frees are batched so that a
+ * grace period is waited for once per RCU_MAX_FREE pointers. */
+void rcu_free(void *ptr) {
+	if (ptr == NULL) {
+		return;
+	}
+
+	rcu_free_ptrs[rcu_n_free++] = ptr;
+	if (rcu_n_free == RCU_MAX_FREE) {
+		rcu_flush_frees();
+	}
+}
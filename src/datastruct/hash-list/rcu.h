@@ -0,0 +1,51 @@
+#ifndef _RCU_H_
+#define _RCU_H_
+
+/////////////////////////////////////////////////////////
+// INCLUDES
+/////////////////////////////////////////////////////////
+#include <stdlib.h>
+
+/////////////////////////////////////////////////////////
+// DEFINES
+/////////////////////////////////////////////////////////
+#define RCU_MAX_THREADS         (512)
+/* Pointers a thread retires before it waits for a grace period and frees them */
+#define RCU_MAX_FREE            (128)
+#define RCU_CACHE_LINE          (64)
+
+/////////////////////////////////////////////////////////
+// TYPES
+/////////////////////////////////////////////////////////
+typedef struct rcu_thread {
+	/* Global time when the thread entered its read side section, 0 outside of one */
+	volatile unsigned long time;
+	char padding[RCU_CACHE_LINE - sizeof(unsigned long)];
+} __attribute__((aligned(RCU_CACHE_LINE))) rcu_thread_t;
+
+extern rcu_thread_t rcu_threads[RCU_MAX_THREADS];
+extern volatile unsigned long rcu_global_time;
+extern __thread int rcu_thread_id;
+
+/////////////////////////////////////////////////////////
+// INTERFACE
+/////////////////////////////////////////////////////////
+void rcu_register(int id);
+void rcu_unregister();
+
+void rcu_synchronize();
+void rcu_free(void *ptr);
+
+/* The fence keeps the reads of the section after the store, so a
+ * synchronize that missed the store cannot miss the section either. */
+static inline void rcu_reader_lock() {
+	__atomic_store_n(&rcu_threads[rcu_thread_id].time,
+		__atomic_load_n(&rcu_global_time, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void rcu_reader_unlock() {
+	__atomic_store_n(&rcu_threads[rcu_thread_id].time, 0, __ATOMIC_RELEASE);
+}
+
+#endif // _RCU_H_
@@ -0,0 +1,225 @@
+/////////////////////////////////////////////////////////
+// INCLUDES
+/////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "mvrlu.h"
+
+/////////////////////////////////////////////////////////
+// DEFINES
+/////////////////////////////////////////////////////////
+#define SKIP_NODE_SIZE(level)   (offsetof(skip_node_t, p_next) + (level) * sizeof(skip_node_t *))
+
+/////////////////////////////////////////////////////////
+// RANDOM LEVEL
+/////////////////////////////////////////////////////////
+static __thread uint64_t level_seed = 0;
+
+/* Level l with probability 1/2^l, one plus the trailing zeros of one xorshift draw */
+static int skip_list_random_level() {
+	uint64_t x = level_seed;
+
+	if (x == 0) {
+		x = (uint64_t)(uintptr_t)&level_seed | 1;
+	}
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	level_seed = x;
+
+	return 1 + __builtin_ctzll(x | (1ULL << (SKIP_LIST_MAX_LEVEL - 1)));
+}
+
+/////////////////////////////////////////////////////////
+// NEW SKIP LIST
+/////////////////////////////////////////////////////////
+static skip_node_t *rlu_new_skip_node(val_t val, int level) {
+	skip_node_t *p_node = (skip_node_t *)rlu_alloc(SKIP_NODE_SIZE(level));
+
+	p_node->val = val;
+	p_node->level = level;
+	return p_node;
+}
+
+skip_list_t *rlu_new_skip_list() {
+	int i;
+	skip_list_t *p_skip_list;
+	skip_node_t *p_min_node, *p_max_node;
+
+	p_skip_list = (skip_list_t *)malloc(sizeof(skip_list_t));
+	if (p_skip_list == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+
+	p_max_node = rlu_new_skip_node(LIST_VAL_MAX, SKIP_LIST_MAX_LEVEL);
+	p_min_node = rlu_new_skip_node(LIST_VAL_MIN, SKIP_LIST_MAX_LEVEL);
+	for (i = 0; i < SKIP_LIST_MAX_LEVEL; i++) {
+		p_max_node->p_next[i] = NULL;
+		p_min_node->p_next[i] = p_max_node;
+	}
+
+	p_skip_list->p_head = p_min_node;
+
+	return p_skip_list;
+}
+
+/////////////////////////////////////////////////////////
+// SKIP LIST SIZE
+/////////////////////////////////////////////////////////
+/* Reads the nodes directly, so every operation must have been written back by rlu_finish */
+int skip_list_size(skip_list_t *p_skip_list)
+{
+	int size = 0;
+	skip_node_t *p_node;
+
+	p_node = p_skip_list->p_head->p_next[0];
+	while (p_node->p_next[0] != NULL) {
+		size++;
+		p_node = p_node->p_next[0];
+	}
+
+	return size;
+}
+
+void skip_list_print(skip_list_t *p_skip_list)
+{
+	skip_node_t *p_node;
+
+	p_node = p_skip_list->p_head->p_next[0];
+	while (p_node->p_next[0] != NULL) {
+		printf("%u ", p_node->val);
+		p_node = p_node->p_next[0];
+	}
+}
+
+/////////////////////////////////////////////////////////
+// SKIP LIST FIND
+/////////////////////////////////////////////////////////
+/* Fills the predecessors and successors of val at every level in the thread's snapshot */
+static void rlu_skip_list_find(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val,
+	skip_node_t **preds, skip_node_t **succs)
+{
+	int level;
+	skip_node_t *p_prev, *p_next;
+
+	p_prev = (skip_node_t *)rlu_deref(self, p_skip_list->p_head);
+	for (level = SKIP_LIST_MAX_LEVEL - 1; level >= 0; level--) {
+		p_next = (skip_node_t *)rlu_deref(self, p_prev->p_next[level]);
+		while (p_next->val < val) {
+			p_prev = p_next;
+			p_next = (skip_node_t *)rlu_deref(self, p_prev->p_next[level]);
+		}
+		preds[level] = p_prev;
+		succs[level] = p_next;
+	}
+}
+
+/////////////////////////////////////////////////////////
+// SKIP LIST CONTAINS
+/////////////////////////////////////////////////////////
+int rlu_skip_list_contains(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val)
+{
+	int level, result;
+	skip_node_t *p_prev, *p_next = NULL;
+
+	rlu_reader_lock(self);
+
+	p_prev = (skip_node_t *)rlu_deref(self, p_skip_list->p_head);
+	for (level = SKIP_LIST_MAX_LEVEL - 1; level >= 0; level--) {
+		p_next = (skip_node_t *)rlu_deref(self, p_prev->p_next[level]);
+		while (p_next->val < val) {
+			p_prev = p_next;
+			p_next = (skip_node_t *)rlu_deref(self, p_prev->p_next[level]);
+		}
+		if (p_next->val == val) {
+			break;
+		}
+	}
+	result = (p_next->val == val);
+
+	rlu_reader_unlock(self);
+	return result;
+}
+
+/////////////////////////////////////////////////////////
+// SKIP LIST ADD
+/////////////////////////////////////////////////////////
+/* Locks the predecessor at every level of the new node. A concurrent
+ * change at any of them makes the try lock fail, the add then restarts
+ * from a newer snapshot. */
+int rlu_skip_list_add(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val)
+{
+	int level, top_level;
+	skip_node_t *preds[SKIP_LIST_MAX_LEVEL], *succs[SKIP_LIST_MAX_LEVEL];
+	skip_node_t *p_new_node;
+
+	top_level = skip_list_random_level();
+
+restart:
+	rlu_reader_lock(self);
+
+	rlu_skip_list_find(self, p_skip_list, val, preds, succs);
+	if (succs[0]->val == val) {
+		rlu_reader_unlock(self);
+		return 0;
+	}
+
+	for (level = 0; level < top_level; level++) {
+		if (!rlu_try_lock(self, (void **)&preds[level])) {
+			rlu_abort(self);
+			goto restart;
+		}
+	}
+
+	p_new_node = rlu_new_skip_node(val, top_level);
+	for (level = 0; level < top_level; level++) {
+		rlu_assign_ptr((void **)&p_new_node->p_next[level], succs[level]);
+		rlu_assign_ptr((void **)&preds[level]->p_next[level], p_new_node);
+	}
+
+	rlu_reader_unlock(self);
+	return 1;
+}
+
+/////////////////////////////////////////////////////////
+// SKIP LIST REMOVE
+/////////////////////////////////////////////////////////
+int rlu_skip_list_remove(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val)
+{
+	int level;
+	skip_node_t *preds[SKIP_LIST_MAX_LEVEL], *succs[SKIP_LIST_MAX_LEVEL];
+	skip_node_t *p_node;
+
+restart:
+	rlu_reader_lock(self);
+
+	rlu_skip_list_find(self, p_skip_list, val, preds, succs);
+	p_node = succs[0];
+	if (p_node->val != val) {
+		rlu_reader_unlock(self);
+		return 0;
+	}
+
+	if (!rlu_try_lock(self, (void **)&p_node)) {
+		rlu_abort(self);
+		goto restart;
+	}
+	for (level = 0; level < p_node->level; level++) {
+		if (!rlu_try_lock(self, (void **)&preds[level])) {
+			rlu_abort(self);
+			goto restart;
+		}
+	}
+
+	for (level = 0; level < p_node->level; level++) {
+		rlu_assign_ptr((void **)&preds[level]->p_next[level], p_node->p_next[level]);
+	}
+	rlu_free(self, p_node);
+
+	rlu_reader_unlock(self);
+	return 1;
+}
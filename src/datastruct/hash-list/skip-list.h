@@ -0,0 +1,23 @@
+#ifndef _SKIP_LIST_H_
+#define _SKIP_LIST_H_
+
+/////////////////////////////////////////////////////////
+// INCLUDES
+/////////////////////////////////////////////////////////
+#include "types.h"
+#include "mvrlu.h"
+
+
+/////////////////////////////////////////////////////////
+// INTERFACE
+/////////////////////////////////////////////////////////
+skip_list_t *rlu_new_skip_list();
+
+int skip_list_size(skip_list_t *p_skip_list);
+void skip_list_print(skip_list_t *p_skip_list);
+
+int rlu_skip_list_contains(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val);
+int rlu_skip_list_add(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val);
+int rlu_skip_list_remove(rlu_thread_data_t *self, skip_list_t *p_skip_list, val_t val);
+
+#endif // _SKIP_LIST_H_
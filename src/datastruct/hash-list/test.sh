@@ -1,6 +1,13 @@
 #!/bin/bash
+# Usage: ./test.sh [update rate] [buckets] [bench options...]
+# The update rate is in 1/1000, e.g. ./test.sh 0 1 for read-only runs on one bucket.
+# Growth runs, e.g. ./test.sh 500 1 -l 2 -g 10000000, add keys up to the given size and print tail latencies.
+
+UPDATE=${1:-50}
+BUCKETS=${2:-100}
+shift $(( $# < 2 ? $# : 2 ))
 
 for i in 1 2 4 8 10 20 30 40 50 60 70 80 90 100 110 120
 do
-		time ./bench -b 100 -i 1000 -r 2000 -u50 -n$i
+		time ./bench -b $BUCKETS -i 1000 -r 2000 -u$UPDATE -n$i "$@"
 done
@@ -11,7 +11,17 @@
 // TYPES
 /////////////////////////////////////////////////////////
 #define NODE_PADDING (16)
-#define MAX_BUCKETS (20000)
+/* Most buckets a resizable hash list grows to */
+#define MAX_BUCKETS (1 << 26)
+/* Counters of the keys in a hash list, one cache line each */
+#define SIZE_STRIPES (64)
+#define SKIP_LIST_MAX_LEVEL (16)
+
+/* Functions that mix a key before its bucket is taken from the low bits */
+#define HASH_TYPE_IDENTITY  (0)
+#define HASH_TYPE_FIBONACCI (1)
+#define HASH_TYPE_MURMUR3   (2)
+#define HASH_TYPE_CRC32C    (3)
 typedef int val_t;
 
 typedef struct node {
@@ -24,11 +34,52 @@ typedef struct node {
 typedef struct list {
 	node_t *p_head;
 	pthread_spinlock_t lock;
+	/* Seqlock of the removes, odd while a node is being unlinked or the bucket moves */
+	volatile unsigned long version;
+	/* Set once the bucket moved to the next table */
+	volatile int migrated;
+	int size;
 } list_t;
 
+typedef struct table {
+	/* A power of two, the bucket of a key is its hash masked with n_buckets - 1 */
+	int n_buckets;
+	unsigned int mask;
+	int hash_type;
+	/* Table of twice the buckets this one is moving to, NULL unless resizing */
+	struct table *volatile p_next;
+	/* Next bucket to move, and the buckets moved so far */
+	volatile int migrate_next;
+	volatile int n_migrated;
+	/* Older tables, kept because lock-free readers may still be on them */
+	struct table *p_retired;
+	list_t **buckets;
+} table_t;
+
+typedef struct size_stripe {
+	volatile long count;
+	long padding[7];
+} size_stripe_t;
+
 typedef struct hash_list {
 	int n_buckets;
-	list_t *buckets[MAX_BUCKETS];  
+	/* Average keys per bucket that doubles the buckets, 0 keeps them fixed */
+	int load_factor;
+	/* Oldest table that still holds keys */
+	table_t *volatile p_table;
+	pthread_mutex_t resize_lock;
+	size_stripe_t sizes[SIZE_STRIPES];
 } hash_list_t;
 
+/* Nodes are allocated with room for level next pointers only */
+typedef struct skip_node {
+	val_t val;
+	int level;
+	struct skip_node *p_next[];
+} skip_node_t;
+
+typedef struct skip_list {
+	skip_node_t *p_head;
+} skip_list_t;
+
 #endif